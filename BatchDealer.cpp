@@ -0,0 +1,246 @@
+#include "batch-dealer.h"
+#include "fp61.h"
+#include "lagrange.h"
+#include "recovery-plan.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+
+/**
+ * The constructor.
+ *  Given N secrets and a common threshold, it immediately generates N degree 
+ *  k-1 polynomials: P_{s}(x) = secret_{s} + a_{s,1}x^{1} + ... + a_{s,k-1}x^{k-1}
+ *  The coefficients come from randomSource, or a new ChaCha20Rng if it's null.
+ */
+BatchDealer::BatchDealer(const std::vector<uint64_t> &secrets, uint64_t threshold, 
+	std::shared_ptr<RandomSource> randomSource) 
+: numSecrets(secrets.size()), threshold(threshold), randomSource(std::move(randomSource)) 
+{
+	for (uint64_t secret : secrets) 
+	{
+		if (secret > Fp61::p-1)
+			throw std::domain_error("Error: The secret is too large.");
+	}
+	if (threshold < 2 || threshold > Fp61::p-1)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+
+	// The coefficient matrix has threshold * numSecrets entries, which mustn't wrap
+	if (threshold > std::numeric_limits<size_t>::max() / std::max<size_t>(1, this->numSecrets))
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+
+	if (!this->randomSource)
+		this->randomSource = std::make_shared<ChaCha20Rng>();
+
+	// Immediately hide the secrets in the degree k-1 polynomials.
+	generateCoefficients(secrets);
+}
+
+
+size_t BatchDealer::getNumSecrets() const 
+{
+	return this->numSecrets;
+}
+
+uint64_t BatchDealer::getThreshold() const 
+{
+	return this->threshold;
+}
+
+const std::vector<uint64_t>& BatchDealer::getXValues() const 
+{
+	return this->xValues;
+}
+
+
+/**
+ * Gets the shares of every secret held by one holder.
+ * 
+ * @param holder The index of the holder, in the order of getXValues().
+ * 
+ * @return A pointer to getNumSecrets() contiguous y-values.
+ */
+const uint64_t* BatchDealer::getColumn(size_t holder) const 
+{
+	if (holder >= this->xValues.size())
+		throw std::out_of_range("Error: There is no holder with that index.");
+
+	return this->columns.data() + holder * this->numSecrets;
+}
+
+
+/**
+ * Generates a share of every secret for each new holder.
+ *  New holders are added after the existing ones.
+ * 
+ * @param newXValues The x-values of the new holders. Must be in [1, p-1] and 
+ *        unique, including against the existing holders.
+ */
+void BatchDealer::generateShares(const std::vector<uint64_t> &newXValues) 
+{
+	SSS_STATS_TIMER(GenerateAdditionalShares);
+
+	std::vector<uint64_t> allXValues(this->xValues);
+	for (uint64_t x : newXValues) 
+	{
+		if (x < 1 || x > Fp61::p-1)
+			throw std::domain_error("Error: A requested x-value is outside the field range.");
+		allXValues.push_back(x);
+	}
+	Lagrange::checkUnique(allXValues);
+	SSS_STATS_COUNT(SharesGenerated, newXValues.size() * this->numSecrets);
+
+	size_t prevHolders = this->xValues.size();
+	this->columns.resize(allXValues.size() * this->numSecrets);
+	for (size_t h = 0; h < newXValues.size(); h++)
+		evaluatePolynomials(this->coefficients.data(), this->threshold, this->numSecrets, 
+			newXValues[h], this->columns.data() + (prevHolders + h) * this->numSecrets);
+
+	this->xValues = std::move(allXValues);
+}
+
+
+/**
+ * Recovers every secret from k holders' columns.
+ *  The Lagrange weights are computed once and applied to each column in turn,
+ *  so the inner loop streams over the secrets.
+ * 
+ * @param xValues The x-values of the holders.
+ * @param columns Each holder's column of numSecrets y-values.
+ * @param numSecrets The number of secrets in each column.
+ * 
+ * @return The secrets.
+ */
+std::vector<uint64_t> BatchDealer::recoverSecrets(const std::vector<uint64_t> &xValues, 
+	const std::vector<const uint64_t*> &columns, size_t numSecrets) 
+{
+	SSS_STATS_TIMER(RecoverSecret);
+
+	if (xValues.size() != columns.size())
+		throw std::invalid_argument("Error: The number of x-values doesn't match the number of columns.");
+
+	RecoveryPlan plan(xValues);
+	const std::vector<uint64_t> &weights = plan.getWeights();
+
+	std::vector<uint64_t> secrets(numSecrets, 0);
+	for (size_t h = 0; h < columns.size(); h++) 
+	{
+		const uint64_t *column = columns[h];
+		uint64_t weight = weights[h];
+		for (size_t s = 0; s < numSecrets; s++)
+		{
+			if (column[s] > Fp61::p-1)
+				throw std::domain_error("Error: A provided share is outside the field range.");
+			secrets[s] = Fp61::add(secrets[s], Fp61::mul(weight, column[s]));
+		}
+	}
+
+	return secrets;
+}
+
+
+/**
+ * Refreshes every holder's shares in place without reconstructing the secrets.
+ *  A random polynomial D_{s} with D_{s}(0) = 0 is drawn for every secret and 
+ *  D_{s}(x_{h}) is added to each holder's share. The new shares are points on 
+ *  P_{s} + D_{s}, which hides the same secret, and they can't be combined 
+ *  with shares from before the refresh.
+ * 
+ * @param xValues The x-values of the holders.
+ * @param columns Each holder's column of numSecrets y-values, updated in place.
+ * @param numSecrets The number of secrets in each column.
+ * @param threshold The threshold the secrets were split with.
+ * @param randomSource The source of the D_{s} coefficients, or null for a new ChaCha20Rng.
+ */
+void BatchDealer::refreshShares(const std::vector<uint64_t> &xValues, 
+	const std::vector<uint64_t*> &columns, size_t numSecrets, uint64_t threshold, 
+	std::shared_ptr<RandomSource> randomSource) 
+{
+	if (xValues.size() != columns.size())
+		throw std::invalid_argument("Error: The number of x-values doesn't match the number of columns.");
+	if (threshold < 2 || threshold > Fp61::p-1)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+	if (threshold > std::numeric_limits<size_t>::max() / std::max<size_t>(1, numSecrets))
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+	for (uint64_t x : xValues) 
+	{
+		if (x < 1 || x > Fp61::p-1)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+	}
+
+	// Every share is checked before any is changed, so an error leaves the 
+	// columns as they were rather than half refreshed
+	for (const uint64_t *column : columns) 
+	{
+		for (size_t s = 0; s < numSecrets; s++)
+		{
+			if (column[s] > Fp61::p-1)
+				throw std::domain_error("Error: A provided share is outside the field range.");
+		}
+	}
+
+	// Row 0, the constant terms, stays zero
+	if (!randomSource)
+		randomSource = std::make_shared<ChaCha20Rng>();
+	std::vector<uint64_t> refresh(threshold * numSecrets, 0);
+	randomSource->fillFieldElements(refresh.data() + numSecrets, refresh.size() - numSecrets);
+
+	std::vector<uint64_t> delta(numSecrets);
+	for (size_t h = 0; h < columns.size(); h++) 
+	{
+		uint64_t *column = columns[h];
+		evaluatePolynomials(refresh.data(), threshold, numSecrets, xValues[h], delta.data());
+		for (size_t s = 0; s < numSecrets; s++)
+			column[s] = Fp61::add(column[s], delta[s]);
+	}
+}
+
+
+/**
+ * Fills the coefficient matrix. Row 0 holds the secrets, rows 1 to k-2 are 
+ * random, and row k-1 is random and non-zero so every polynomial has degree k-1.
+ * 
+ * @param secrets The secrets to hide.
+ */
+void BatchDealer::generateCoefficients(const std::vector<uint64_t> &secrets) 
+{
+	SSS_STATS_TIMER(GenerateCoefficients);
+
+	this->coefficients.resize(this->threshold * this->numSecrets);
+	std::copy(secrets.begin(), secrets.end(), this->coefficients.begin());
+
+	size_t leadingRow = (this->threshold-1) * this->numSecrets;
+	this->randomSource->fillFieldElements(this->coefficients.data() + this->numSecrets, 
+		leadingRow - this->numSecrets, 0);
+	this->randomSource->fillFieldElements(this->coefficients.data() + leadingRow, this->numSecrets, 1);
+}
+
+
+/**
+ * Evaluates every secret's polynomial at one x-value with Horner's scheme.
+ *  Each step walks one coefficient row and the output column in lockstep, 
+ *  so every pass is a contiguous stream with no dependencies between secrets.
+ * 
+ * @param coefficients The coefficient-major matrix of threshold rows.
+ * @param threshold The number of rows.
+ * @param numSecrets The number of polynomials in each row.
+ * @param x The x-value.
+ * @param yValues The output column of numSecrets y-values.
+ */
+void BatchDealer::evaluatePolynomials(const uint64_t *coefficients, size_t threshold, size_t numSecrets, 
+	uint64_t x, uint64_t *yValues) 
+{
+	SSS_STATS_TIMER(EvaluatePolynomial);
+
+	const uint64_t *row = coefficients + (threshold-1) * numSecrets;
+	std::copy(row, row + numSecrets, yValues);
+
+	for (size_t j = threshold-1; j-- > 0;) 
+	{
+		row = coefficients + j * numSecrets;
+		for (size_t s = 0; s < numSecrets; s++)
+			yValues[s] = Fp61::add(Fp61::mul(yValues[s], x), row[s]);
+	}
+}
@@ -0,0 +1,457 @@
+#include "bulk-processor.h"
+#include "batch-dealer.h"
+#include "fp61.h"
+#include "recovery-plan.h"
+#include "share-file.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+
+/**
+ * Reads whitespace-separated numbers a line at a time, parsing them with 
+ * std::from_chars straight out of a large buffer.
+ */
+class TextReader {
+public:
+	explicit TextReader(std::istream &in) : in(in), buffer(bufferBytes) {}
+
+	size_t readLine(std::vector<uint64_t> &values);
+
+private:
+	static constexpr size_t bufferBytes = 1 << 20;
+
+	std::istream &in;
+	std::vector<char> buffer;
+	size_t begin = 0, end = 0;
+	bool finished = false;
+
+	bool fill();
+	static bool isSeparator(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+};
+
+
+/**
+ * Moves the unread bytes to the front of the buffer and reads more after them.
+ * 
+ * @return False if the input has ended.
+ */
+bool TextReader::fill() 
+{
+	if (this->finished)
+		return false;
+	if (this->end - this->begin == this->buffer.size())
+		throw std::invalid_argument("Error: A number in the input is too long.");
+
+	std::memmove(this->buffer.data(), this->buffer.data() + this->begin, this->end - this->begin);
+	this->end -= this->begin;
+	this->begin = 0;
+
+	this->in.read(this->buffer.data() + this->end, this->buffer.size() - this->end);
+	size_t bytesRead = static_cast<size_t>(this->in.gcount());
+	this->end += bytesRead;
+	this->finished = bytesRead == 0;
+
+	return bytesRead > 0;
+}
+
+
+/**
+ * Appends the numbers on the next non-blank line.
+ * 
+ * @param values The numbers are appended to this.
+ * 
+ * @return The number of numbers read, 0 at the end of the input.
+ */
+size_t TextReader::readLine(std::vector<uint64_t> &values) 
+{
+	size_t numRead = 0;
+	while (true) 
+	{
+		if (this->begin == this->end && !fill())
+			return numRead;
+
+		char c = this->buffer[this->begin];
+		if (c == '\n') 
+		{
+			this->begin++;
+			if (numRead > 0)
+				return numRead;
+			continue;
+		}
+		if (isSeparator(c)) 
+		{
+			this->begin++;
+			continue;
+		}
+
+		// Make sure the whole number is in the buffer before parsing it
+		size_t length = 0;
+		while (true) 
+		{
+			while (this->begin + length < this->end && !isSeparator(this->buffer[this->begin + length]))
+				length++;
+			if (this->begin + length < this->end || !fill())
+				break;
+		}
+
+		const char *first = this->buffer.data() + this->begin;
+		uint64_t value;
+		auto [last, error] = std::from_chars(first, first + length, value);
+		if (error != std::errc() || last != first + length)
+			throw std::invalid_argument("Error: Expected a number but found \"" + std::string(first, length) + "\".");
+
+		values.push_back(value);
+		numRead++;
+		this->begin += length;
+	}
+}
+
+
+static void appendNumber(std::string &text, uint64_t value) 
+{
+	char digits[20];
+	char *last = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+	text.append(digits, last);
+}
+
+
+BulkProcessor::BulkProcessor(unsigned numThreads) 
+: pool(numThreads) 
+{
+}
+
+
+/**
+ * Runs read -> compute -> write over every chunk of the input. Chunk i+1 is 
+ * read and chunk i-1 written on their own threads while chunk i is computed 
+ * on the pool, and the chunks are written in order.
+ * 
+ * @param read Fills the next chunk, returning false when the input has ended.
+ * @param compute Computes a chunk's output.
+ * @param write Writes a chunk's output.
+ */
+void BulkProcessor::runPipeline(const std::function<bool(Chunk&)> &read, const std::function<void(Chunk&)> &compute, 
+	const std::function<void(Chunk&)> &write) 
+{
+	size_t numRecords = 0;
+	auto readNext = [&read, &numRecords]() 
+	{
+		std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>();
+		chunk->first = numRecords;
+		if (!read(*chunk))
+			chunk.reset();
+		else
+			numRecords += chunk->size();
+		return chunk;
+	};
+
+	std::future<std::unique_ptr<Chunk>> reading = std::async(std::launch::async, readNext);
+	std::future<void> writing;
+	while (std::unique_ptr<Chunk> chunk = reading.get()) 
+	{
+		reading = std::async(std::launch::async, readNext);
+		compute(*chunk);
+
+		if (writing.valid())
+			writing.get();
+		writing = std::async(std::launch::async, [&write](std::unique_ptr<Chunk> chunk) { write(*chunk); }, std::move(chunk));
+	}
+
+	if (writing.valid())
+		writing.get();
+}
+
+
+/**
+ * Reads up to chunkRecords lines of numbers into a chunk.
+ * 
+ * @return False if there were no more lines.
+ */
+bool BulkProcessor::readRecords(TextReader &reader, Chunk &chunk) 
+{
+	while (chunk.size() < chunkRecords && reader.readLine(chunk.values) > 0)
+		chunk.recordEnds.push_back(chunk.values.size());
+
+	return chunk.size() > 0;
+}
+
+
+void BulkProcessor::writeText(std::ostream &out, const Chunk &chunk) 
+{
+	for (const std::string &piece : chunk.text)
+		out.write(piece.data(), piece.size());
+}
+
+
+/**
+ * Splits every secret in a chunk, with each thread dealing its own part of 
+ * the chunk so the random polynomials are drawn independently.
+ * 
+ * @param chunk The chunk, with one secret per record.
+ * @param threshold The number of shares needed to recover each secret (k).
+ * @param numShares The number of shares of each secret (n), at x = 1, ..., n.
+ * @param formatText Whether to write share lines to chunk.text or y-values to chunk.columns.
+ */
+void BulkProcessor::splitChunk(Chunk &chunk, uint64_t threshold, uint64_t numShares, bool formatText) 
+{
+	size_t count = chunk.size();
+	for (size_t r = 0; r < count; r++) 
+	{
+		if (chunk.recordEnds[r] != r+1)
+			throw std::invalid_argument("Error: Expected one secret per line, on line " + std::to_string(chunk.first + r + 1) + ".");
+	}
+
+	std::vector<uint64_t> xValues(numShares);
+	for (uint64_t h = 0; h < numShares; h++)
+		xValues[h] = h+1;
+
+	size_t pieces = this->pool.size();
+	chunk.text.assign(pieces, std::string());
+	if (!formatText)
+		chunk.columns.resize(numShares * count);
+
+	this->pool.parallelFor(pieces, [&](size_t firstPiece, size_t lastPiece) 
+	{
+		for (size_t piece = firstPiece; piece < lastPiece; piece++) 
+		{
+			size_t begin = count * piece / pieces, end = count * (piece+1) / pieces;
+			if (begin == end)
+				continue;
+
+			std::vector<uint64_t> secrets(chunk.values.begin() + begin, chunk.values.begin() + end);
+			BatchDealer dealer(secrets, threshold);
+			dealer.generateShares(xValues);
+
+			if (!formatText) 
+			{
+				for (size_t h = 0; h < numShares; h++)
+					std::copy(dealer.getColumn(h), dealer.getColumn(h) + secrets.size(), chunk.columns.begin() + h*count + begin);
+				continue;
+			}
+
+			std::string &text = chunk.text[piece];
+			for (size_t s = 0; s < secrets.size(); s++) 
+			{
+				for (size_t h = 0; h < numShares; h++) 
+				{
+					if (h > 0)
+						text.push_back(' ');
+					appendNumber(text, xValues[h]);
+					text.push_back(' ');
+					appendNumber(text, dealer.getColumn(h)[s]);
+				}
+				text.push_back('\n');
+			}
+		}
+	});
+}
+
+
+/**
+ * Splits every secret in the input and writes one line of shares per secret.
+ * 
+ * @param secrets The secrets, one per line.
+ * @param shares The output, one line x_{1} y_{1} ... x_{n} y_{n} per secret.
+ * @param threshold The number of shares needed to recover each secret (k).
+ * @param numShares The number of shares of each secret (n), at x = 1, ..., n.
+ */
+void BulkProcessor::split(std::istream &secrets, std::ostream &shares, uint64_t threshold, uint64_t numShares) 
+{
+	if (numShares < 1 || numShares > Fp61::p-1)
+		throw std::domain_error("Error: The number of shares requested is outside the range.");
+	if (threshold < 2 || threshold > Fp61::p-1)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+	if (numShares < threshold)
+		throw std::domain_error("Error: The number of shares (n) is less than the threshold (k).");
+
+	TextReader reader(secrets);
+	runPipeline(
+		[&](Chunk &chunk) { return readRecords(reader, chunk); },
+		[&](Chunk &chunk) { splitChunk(chunk, threshold, numShares, true); },
+		[&](Chunk &chunk) { writeText(shares, chunk); });
+
+	shares.flush();
+	if (!shares)
+		throw std::runtime_error("Error: Couldn't write the shares.");
+}
+
+
+/**
+ * Splits every secret in the input into one share file per holder, named 
+ * prefix.1, ..., prefix.n. Holder h's file is a Column of its share of every 
+ * secret, in input order.
+ * 
+ * @param secrets The secrets, one per line.
+ * @param prefix The start of each share file's path.
+ * @param threshold The number of shares needed to recover each secret (k).
+ * @param numShares The number of holders (n), at x = 1, ..., n.
+ */
+void BulkProcessor::splitToFiles(std::istream &secrets, const std::string &prefix, uint64_t threshold, uint64_t numShares) 
+{
+	if (numShares < 1 || numShares > Fp61::p-1)
+		throw std::domain_error("Error: The number of shares requested is outside the range.");
+	if (threshold < 2 || threshold > Fp61::p-1)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+	if (numShares < threshold)
+		throw std::domain_error("Error: The number of shares (n) is less than the threshold (k).");
+
+	std::vector<std::unique_ptr<ShareFileWriter>> writers;
+	for (uint64_t h = 1; h <= numShares; h++)
+		writers.push_back(std::make_unique<ShareFileWriter>(prefix + "." + std::to_string(h), ShareFile::Layout::Column, threshold, h));
+
+	TextReader reader(secrets);
+	runPipeline(
+		[&](Chunk &chunk) { return readRecords(reader, chunk); },
+		[&](Chunk &chunk) { splitChunk(chunk, threshold, numShares, false); },
+		[&](Chunk &chunk) 
+		{
+			for (size_t h = 0; h < writers.size(); h++)
+				writers[h]->append(chunk.columns.data() + h * chunk.size(), chunk.size());
+		});
+
+	for (std::unique_ptr<ShareFileWriter> &writer : writers)
+		writer->close();
+}
+
+
+/**
+ * Recovers the secret of every line of shares.
+ * 
+ * @param shares The input, one line x_{1} y_{1} ... x_{k} y_{k} per secret.
+ * @param secrets The output, one secret per line.
+ */
+void BulkProcessor::combine(std::istream &shares, std::ostream &secrets) 
+{
+	TextReader reader(shares);
+	auto compute = [&](Chunk &chunk) 
+	{
+		size_t count = chunk.size(), pieces = this->pool.size();
+		chunk.text.assign(pieces, std::string());
+
+		this->pool.parallelFor(pieces, [&](size_t firstPiece, size_t lastPiece) 
+		{
+			// Consecutive lines usually come from the same holders, so the 
+			// last recovery plan is kept while the x-values stay the same
+			std::unique_ptr<RecoveryPlan> plan;
+			std::vector<uint64_t> xValues, yValues;
+			for (size_t piece = firstPiece; piece < lastPiece; piece++) 
+			{
+				for (size_t r = count * piece / pieces; r < count * (piece+1) / pieces; r++) 
+				{
+					size_t begin = r == 0 ? 0 : chunk.recordEnds[r-1], end = chunk.recordEnds[r];
+					if ((end - begin) % 2 != 0)
+						throw std::invalid_argument("Error: Expected x y pairs, on line " + std::to_string(chunk.first + r + 1) + ".");
+
+					xValues.clear();
+					yValues.clear();
+					for (size_t i = begin; i < end; i += 2)
+					{
+						if (chunk.values[i+1] > Fp61::p-1)
+							throw std::domain_error("Error: A provided share is outside the field range.");
+						xValues.push_back(chunk.values[i]);
+						yValues.push_back(chunk.values[i+1]);
+					}
+					SSS_STATS_TIMER(RecoverSecret);
+					if (!plan || plan->getXValues() != xValues)
+						plan = std::make_unique<RecoveryPlan>(xValues);
+
+					appendNumber(chunk.text[piece], plan->recover(yValues));
+					chunk.text[piece].push_back('\n');
+				}
+			}
+		});
+	};
+
+	runPipeline(
+		[&](Chunk &chunk) { return readRecords(reader, chunk); },
+		compute,
+		[&](Chunk &chunk) { writeText(secrets, chunk); });
+
+	secrets.flush();
+	if (!secrets)
+		throw std::runtime_error("Error: Couldn't write the secrets.");
+}
+
+
+/**
+ * Recovers every secret from k holders' share files. The files are mapped, 
+ * so each chunk of secrets is recovered straight from the mapped pages, 
+ * once every file's checksum has been verified.
+ * 
+ * @param paths The holders' Column share files.
+ * @param secrets The output, one secret per line.
+ */
+void BulkProcessor::combineFiles(const std::vector<std::string> &paths, std::ostream &secrets) 
+{
+	std::vector<ShareFile> files;
+	std::vector<uint64_t> xValues;
+	for (const std::string &path : paths) 
+	{
+		files.emplace_back(path);
+		if (files.back().getLayout() != ShareFile::Layout::Column)
+			throw std::invalid_argument("Error: " + path + " doesn't hold a holder's column of shares.");
+		if (files.back().size() != files[0].size())
+			throw std::invalid_argument("Error: The share files hold different numbers of secrets.");
+		if (files.back().getThreshold() != files[0].getThreshold())
+			throw std::invalid_argument("Error: The share files were split with different thresholds.");
+		xValues.push_back(files.back().getFirstX());
+	}
+	if (files.empty() || files.size() < files[0].getThreshold())
+		throw std::invalid_argument("Error: Fewer share files were given than the threshold (k).");
+
+	// Opening only checks the headers, so a flipped bit in the y-words would 
+	// give wrong secrets. Every page is read once here, a file per thread.
+	std::vector<char> intact(files.size());
+	this->pool.parallelFor(files.size(), [&](size_t first, size_t last) 
+	{
+		for (size_t f = first; f < last; f++)
+			intact[f] = files[f].verifyChecksum();
+	});
+	for (size_t f = 0; f < files.size(); f++) 
+	{
+		if (!intact[f])
+			throw std::invalid_argument("Error: " + paths[f] + " is corrupted; its checksum doesn't match.");
+	}
+	size_t numSecrets = files[0].size();
+
+	auto read = [&](Chunk &chunk) 
+	{
+		size_t count = std::min(chunkRecords, numSecrets - chunk.first);
+		chunk.recordEnds.resize(count);
+		return count > 0;
+	};
+	auto compute = [&](Chunk &chunk) 
+	{
+		size_t count = chunk.size(), pieces = this->pool.size();
+		chunk.text.assign(pieces, std::string());
+
+		this->pool.parallelFor(pieces, [&](size_t firstPiece, size_t lastPiece) 
+		{
+			for (size_t piece = firstPiece; piece < lastPiece; piece++) 
+			{
+				size_t begin = chunk.first + count * piece / pieces, end = chunk.first + count * (piece+1) / pieces;
+				std::vector<const uint64_t*> columns;
+				for (const ShareFile &file : files)
+					columns.push_back(file.getYValues() + begin);
+
+				for (uint64_t secret : BatchDealer::recoverSecrets(xValues, columns, end - begin)) 
+				{
+					appendNumber(chunk.text[piece], secret);
+					chunk.text[piece].push_back('\n');
+				}
+			}
+		});
+	};
+
+	runPipeline(read, compute, [&](Chunk &chunk) { writeText(secrets, chunk); });
+
+	secrets.flush();
+	if (!secrets)
+		throw std::runtime_error("Error: Couldn't write the secrets.");
+}
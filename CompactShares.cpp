@@ -0,0 +1,208 @@
+#include "compact-shares.h"
+#include "fp61.h"
+
+#include <stdexcept>
+
+
+CompactShares::CompactShares(uint64_t firstX, Layout layout) 
+: firstX(firstX), layout(layout), count(0) 
+{
+	if (firstX < 1 || firstX > Fp61::p-1)
+		throw std::domain_error("Error: The first x-value is outside the field range.");
+}
+
+
+/**
+ * Copies shares into another layout, for example to pack them for storage.
+ */
+CompactShares::CompactShares(const CompactShares &other, Layout layout) 
+: CompactShares(other.firstX, layout) 
+{
+	resize(other.count);
+	for (size_t i = 0; i < other.count; i++)
+		setY(i, other.getY(i));
+}
+
+
+uint64_t CompactShares::getFirstX() const 
+{
+	return this->firstX;
+}
+
+CompactShares::Layout CompactShares::getLayout() const 
+{
+	return this->layout;
+}
+
+size_t CompactShares::size() const 
+{
+	return this->count;
+}
+
+bool CompactShares::empty() const 
+{
+	return this->count == 0;
+}
+
+size_t CompactShares::getNumBytes() const 
+{
+	return this->words.size() * sizeof(uint64_t);
+}
+
+
+/**
+ * Gets the y-value of the i-th share, at x = firstX + i.
+ *  A packed value starts at bit 61i and may straddle two words.
+ */
+uint64_t CompactShares::getY(size_t i) const 
+{
+	if (this->layout == Layout::Words)
+		return this->words[i];
+
+	size_t bit = i * packedBits;
+	size_t word = bit / 64;
+	unsigned offset = bit % 64;
+
+	uint64_t y = this->words[word] >> offset;
+	if (offset + packedBits > 64)
+		y |= this->words[word+1] << (64 - offset);
+	return y & packedMask;
+}
+
+
+void CompactShares::setY(size_t i, uint64_t y) 
+{
+	if (y > Fp61::p-1)
+		throw std::domain_error("Error: A provided share is outside the field range.");
+
+	if (this->layout == Layout::Words) 
+	{
+		this->words[i] = y;
+		return;
+	}
+
+	size_t bit = i * packedBits;
+	size_t word = bit / 64;
+	unsigned offset = bit % 64;
+
+	this->words[word] = (this->words[word] & ~(packedMask << offset)) | (y << offset);
+	if (offset + packedBits > 64) 
+	{
+		unsigned spill = 64 - offset;
+		this->words[word+1] = (this->words[word+1] & ~(packedMask >> spill)) | (y >> spill);
+	}
+}
+
+
+void CompactShares::push_back(uint64_t y) 
+{
+	resize(this->count + 1);
+	setY(this->count - 1, y);
+}
+
+
+/**
+ * Changes the number of shares. New shares have y = 0 until they are set.
+ */
+void CompactShares::resize(size_t count) 
+{
+	if (count > Fp61::p - this->firstX)
+		throw std::domain_error("Error: The number of shares is outside the range.");
+
+	// Clear the bits of any packed values being dropped from a shared word
+	for (size_t i = count; i < this->count && this->layout == Layout::Packed61; i++)
+		setY(i, 0);
+
+	this->words.resize(wordsFor(count, this->layout), 0);
+	this->count = count;
+}
+
+
+/**
+ * Unpacks a range of y-values into a contiguous buffer.
+ */
+void CompactShares::copyY(size_t first, size_t count, uint64_t *yValues) const 
+{
+	if (first > this->count || count > this->count - first)
+		throw std::out_of_range("Error: The range of shares is outside the container.");
+
+	for (size_t i = 0; i < count; i++)
+		yValues[i] = getY(first + i);
+}
+
+
+uint64_t* CompactShares::data() 
+{
+	if (this->layout != Layout::Words)
+		throw std::logic_error("Error: Packed shares can't be accessed in place.");
+	return this->words.data();
+}
+
+const uint64_t* CompactShares::data() const 
+{
+	if (this->layout != Layout::Words)
+		throw std::logic_error("Error: Packed shares can't be accessed in place.");
+	return this->words.data();
+}
+
+
+Share CompactShares::operator[](size_t i) const 
+{
+	return {this->firstX + i, getY(i)};
+}
+
+
+/**
+ * Expands to the usual list of shares, for callers that need one.
+ */
+CompactShares::operator std::vector<Share>() const 
+{
+	std::vector<Share> shares(this->count);
+	for (size_t i = 0; i < this->count; i++)
+		shares[i] = (*this)[i];
+
+	return shares;
+}
+
+
+/**
+ * Compares the shares themselves, regardless of layout.
+ */
+bool CompactShares::operator==(const CompactShares &other) const 
+{
+	if (this->firstX != other.firstX || this->count != other.count)
+		return false;
+	if (this->layout == other.layout)
+		return this->words == other.words;
+
+	for (size_t i = 0; i < this->count; i++)
+	{
+		if (getY(i) != other.getY(i))
+			return false;
+	}
+	return true;
+}
+
+bool CompactShares::operator!=(const CompactShares &other) const 
+{
+	return !(*this == other);
+}
+
+
+CompactShares::const_iterator CompactShares::begin() const 
+{
+	return const_iterator(this, 0);
+}
+
+CompactShares::const_iterator CompactShares::end() const 
+{
+	return const_iterator(this, this->count);
+}
+
+
+size_t CompactShares::wordsFor(size_t count, Layout layout) 
+{
+	if (layout == Layout::Words)
+		return count;
+	return (count * packedBits + 63) / 64;
+}
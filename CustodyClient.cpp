@@ -0,0 +1,212 @@
+#include "custody-client.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+/**
+ * The constructor. Connects to the daemon listening at socketPath.
+ */
+CustodyClient::CustodyClient(const std::string &socketPath) 
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+		throw std::invalid_argument("Error: The socket path is empty or too long.");
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+	this->fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (this->fd < 0 || ::connect(this->fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) 
+	{
+		std::string reason = std::strerror(errno);
+		if (this->fd >= 0)
+			::close(this->fd);
+		throw std::runtime_error("Error: Couldn't connect to " + socketPath + ": " + reason);
+	}
+}
+
+
+CustodyClient::~CustodyClient() 
+{
+	::close(this->fd);
+}
+
+
+/**
+ * Splits a secret into shares at x = 1, ..., n.
+ * 
+ * @param secret The secret.
+ * @param threshold The number of shares needed to recover it (k).
+ * @param numShares The number of shares (n).
+ * 
+ * @return The shares.
+ */
+std::vector<Share> CustodyClient::split(uint64_t secret, uint64_t threshold, uint64_t numShares) 
+{
+	std::vector<uint64_t> yValues = call(CustodyProtocol::Opcode::Split, {secret, threshold, numShares});
+
+	std::vector<Share> shares(yValues.size());
+	for (size_t i = 0; i < yValues.size(); i++)
+		shares[i] = {i + 1, yValues[i]};
+	return shares;
+}
+
+
+/**
+ * Recovers a secret from its shares.
+ * 
+ * @param shares The shares.
+ * 
+ * @return The secret.
+ */
+uint64_t CustodyClient::recover(const std::vector<Share> &shares) 
+{
+	std::vector<uint64_t> payload;
+	for (const auto &[x, y] : shares) 
+	{
+		payload.push_back(x);
+		payload.push_back(y);
+	}
+
+	std::vector<uint64_t> words = call(CustodyProtocol::Opcode::Recover, payload);
+	if (words.size() != 1)
+		throw std::runtime_error("Error: The daemon sent a malformed response.");
+	return words[0];
+}
+
+
+/**
+ * Refreshes shares so they can't be combined with the old ones.
+ * 
+ * @param shares The shares.
+ * @param threshold The threshold the secret was split with.
+ * 
+ * @return The refreshed shares, at the same x-values.
+ */
+std::vector<Share> CustodyClient::refresh(const std::vector<Share> &shares, uint64_t threshold) 
+{
+	std::vector<uint64_t> payload = {threshold};
+	for (const auto &[x, y] : shares) 
+	{
+		payload.push_back(x);
+		payload.push_back(y);
+	}
+
+	std::vector<uint64_t> yValues = call(CustodyProtocol::Opcode::Refresh, payload);
+	if (yValues.size() != shares.size())
+		throw std::runtime_error("Error: The daemon sent a malformed response.");
+
+	std::vector<Share> refreshed(shares);
+	for (size_t i = 0; i < refreshed.size(); i++)
+		refreshed[i].second = yValues[i];
+	return refreshed;
+}
+
+
+/**
+ * Sends a request without waiting for the response.
+ * 
+ * @param opcode The request type.
+ * @param payload The request's words.
+ * 
+ * @return The request's id, which its response will carry.
+ */
+uint32_t CustodyClient::send(CustodyProtocol::Opcode opcode, const std::vector<uint64_t> &payload) 
+{
+	CustodyProtocol::Header header{};
+	header.id = this->nextId++;
+	header.opcode = static_cast<uint16_t>(opcode);
+
+	std::vector<char> frame;
+	CustodyProtocol::appendFrame(frame, header, payload.data(), static_cast<uint32_t>(payload.size() * sizeof(uint64_t)));
+
+	size_t sent = 0;
+	while (sent < frame.size()) 
+	{
+		ssize_t result = ::send(this->fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result < 0)
+			throw std::runtime_error(std::string("Error: Couldn't send the request: ") + std::strerror(errno));
+		sent += result;
+	}
+
+	return header.id;
+}
+
+
+/**
+ * Waits for the next response.
+ * 
+ * @return The response.
+ */
+CustodyClient::Response CustodyClient::receive() 
+{
+	Response response;
+	readFully(&response.header, sizeof(response.header));
+	if (response.header.length > CustodyProtocol::maxPayload)
+		throw std::runtime_error("Error: The daemon sent a malformed response.");
+
+	if (response.header.status == static_cast<uint16_t>(CustodyProtocol::Status::Ok)) 
+	{
+		if (response.header.length % sizeof(uint64_t) != 0)
+			throw std::runtime_error("Error: The daemon sent a malformed response.");
+		response.words.resize(response.header.length / sizeof(uint64_t));
+		readFully(response.words.data(), response.header.length);
+	}
+	else 
+	{
+		response.message.resize(response.header.length);
+		readFully(response.message.data(), response.header.length);
+	}
+
+	return response;
+}
+
+
+/**
+ * Sends a request and waits for its response, turning an error status back 
+ * into the exception the library would have thrown.
+ */
+std::vector<uint64_t> CustodyClient::call(CustodyProtocol::Opcode opcode, const std::vector<uint64_t> &payload) 
+{
+	uint32_t id = send(opcode, payload);
+	Response response = receive();
+	if (response.header.id != id)
+		throw std::runtime_error("Error: The daemon answered a different request.");
+
+	switch (static_cast<CustodyProtocol::Status>(response.header.status)) 
+	{
+		case CustodyProtocol::Status::Ok:
+			return response.words;
+		case CustodyProtocol::Status::InvalidArgument:
+			throw std::invalid_argument(response.message);
+		case CustodyProtocol::Status::OutOfRange:
+			throw std::domain_error(response.message);
+		default:
+			throw std::runtime_error(response.message);
+	}
+}
+
+
+void CustodyClient::readFully(void *data, size_t length) 
+{
+	char *bytes = static_cast<char*>(data);
+	while (length > 0) 
+	{
+		ssize_t received = ::read(this->fd, bytes, length);
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received < 0)
+			throw std::runtime_error(std::string("Error: Couldn't read the response: ") + std::strerror(errno));
+		if (received == 0)
+			throw std::runtime_error("Error: The daemon closed the connection.");
+		bytes += received;
+		length -= received;
+	}
+}
@@ -0,0 +1,739 @@
+#include "custody-server.h"
+#include "batch-dealer.h"
+#include "random-source.h"
+#include "recovery-plan.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+// The epoll ids of the fds which aren't connections. Connections count up from 3.
+static constexpr uint64_t listenId = 0, replyId = 1, stopId = 2;
+
+// The recovery plans each worker keeps for the holder sets it has seen recently
+static constexpr size_t planCapacity = 64;
+
+
+static void appendError(std::vector<char> &buffer, CustodyProtocol::Header header, 
+	CustodyProtocol::Status status, const std::string &message) 
+{
+	header.status = static_cast<uint16_t>(status);
+	CustodyProtocol::appendFrame(buffer, header, message.data(), static_cast<uint32_t>(message.size()));
+}
+
+
+/**
+ * The state a worker keeps warm between batches, and the request handlers.
+ *  Each handler serves a group of compatible requests at once and only 
+ *  replies once every result is ready, so a group that throws can be retried 
+ *  one request at a time to find out which of them was bad.
+ */
+class CustodyServer::Worker {
+public:
+	explicit Worker(CustodyServer &server) 
+	: server(server), randomSource(std::make_shared<ChaCha20Rng>()), plans(planCapacity) 
+	{
+	}
+
+	void process(std::vector<Job> &batch);
+
+private:
+	using Group = std::vector<Job*>;
+	using Handler = void (Worker::*)(const Group&);
+
+	CustodyServer &server;
+	std::shared_ptr<RandomSource> randomSource;
+	RecoveryPlanCache plans;
+
+	void runGroup(const Group &group, Handler handler);
+	void split(const Group &group);
+	void recover(const Group &group);
+	void refresh(const Group &group);
+	void reply(const Job &job, const uint64_t *words, size_t count);
+	void fail(const Job &job, CustodyProtocol::Status status, const std::string &message);
+};
+
+
+/**
+ * Sorts a batch into groups which can be served together: splits by (k, n), 
+ * recoveries by their sorted x-values, and refreshes by k and their x-values.
+ * Malformed requests are answered straight away.
+ * 
+ * @param batch The requests taken from the queue.
+ */
+void CustodyServer::Worker::process(std::vector<Job> &batch) 
+{
+	std::map<std::pair<uint64_t, uint64_t>, Group> splits;
+	std::map<std::vector<uint64_t>, Group> recoveries, refreshes;
+
+	for (Job &job : batch) 
+	{
+		std::vector<uint64_t> &payload = job.payload;
+		switch (static_cast<CustodyProtocol::Opcode>(job.header.opcode)) 
+		{
+			case CustodyProtocol::Opcode::Split: 
+			{
+				if (payload.size() != 3) 
+				{
+					fail(job, CustodyProtocol::Status::InvalidArgument, "Error: A split request is [secret, k, n].");
+					break;
+				}
+				splits[{payload[1], payload[2]}].push_back(&job);
+				break;
+			}
+			case CustodyProtocol::Opcode::Recover: 
+			{
+				if (payload.empty() || payload.size() % 2 != 0) 
+				{
+					fail(job, CustodyProtocol::Status::InvalidArgument, "Error: A recover request is a list of x y pairs.");
+					break;
+				}
+				if (payload.size() / 2 > CustodyProtocol::maxShares) 
+				{
+					fail(job, CustodyProtocol::Status::OutOfRange, "Error: The number of shares is outside the range.");
+					break;
+				}
+
+				// The shares are put in x order, which is how the plans are cached
+				std::vector<std::pair<uint64_t, uint64_t>> shares(payload.size() / 2);
+				for (size_t i = 0; i < shares.size(); i++)
+					shares[i] = {payload[2*i], payload[2*i + 1]};
+				std::sort(shares.begin(), shares.end());
+
+				std::vector<uint64_t> xValues(shares.size());
+				for (size_t i = 0; i < shares.size(); i++) 
+				{
+					xValues[i] = payload[2*i] = shares[i].first;
+					payload[2*i + 1] = shares[i].second;
+				}
+				recoveries[xValues].push_back(&job);
+				break;
+			}
+			case CustodyProtocol::Opcode::Refresh: 
+			{
+				if (payload.size() < 3 || payload.size() % 2 != 1) 
+				{
+					fail(job, CustodyProtocol::Status::InvalidArgument, "Error: A refresh request is k followed by a list of x y pairs.");
+					break;
+				}
+
+				// Checked before grouping, since a batch sizes its refresh matrix by k
+				size_t numHolders = payload.size() / 2;
+				if (numHolders > CustodyProtocol::maxShares) 
+				{
+					fail(job, CustodyProtocol::Status::OutOfRange, "Error: The number of shares is outside the range.");
+					break;
+				}
+				if (payload[0] > CustodyProtocol::maxShares || payload[0] > numHolders) 
+				{
+					fail(job, CustodyProtocol::Status::OutOfRange, "Error: The threshold (k) is outside the range.");
+					break;
+				}
+
+				std::vector<uint64_t> key = {payload[0]};
+				for (size_t i = 1; i < payload.size(); i += 2)
+					key.push_back(payload[i]);
+				refreshes[key].push_back(&job);
+				break;
+			}
+		}
+	}
+
+	for (const auto &entry : splits)
+		runGroup(entry.second, &Worker::split);
+	for (const auto &entry : recoveries)
+		runGroup(entry.second, &Worker::recover);
+	for (const auto &entry : refreshes)
+		runGroup(entry.second, &Worker::refresh);
+}
+
+
+/**
+ * Serves a group, falling back to one request at a time if it fails.
+ *  Errors are reported with the status matching the exception type.
+ */
+void CustodyServer::Worker::runGroup(const Group &group, Handler handler) 
+{
+	try 
+	{
+		(this->*handler)(group);
+	}
+	catch (const std::exception &e) 
+	{
+		if (group.size() > 1) 
+		{
+			for (Job *job : group)
+				runGroup({job}, handler);
+			return;
+		}
+
+		CustodyProtocol::Status status = CustodyProtocol::Status::Internal;
+		if (dynamic_cast<const std::domain_error*>(&e) || dynamic_cast<const std::out_of_range*>(&e))
+			status = CustodyProtocol::Status::OutOfRange;
+		else if (dynamic_cast<const std::invalid_argument*>(&e))
+			status = CustodyProtocol::Status::InvalidArgument;
+		fail(*group[0], status, e.what());
+	}
+}
+
+
+/**
+ * Splits every secret in the group with one BatchDealer, so the coefficients 
+ * are drawn in one call and each x-value is evaluated for all of them at once.
+ */
+void CustodyServer::Worker::split(const Group &group) 
+{
+	uint64_t k = group[0]->payload[1], n = group[0]->payload[2];
+	if (k > CustodyProtocol::maxShares)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+	if (n < 1 || n > CustodyProtocol::maxShares)
+		throw std::domain_error("Error: The number of shares (n) is outside the range.");
+
+	// The dealer is gone after the reply, so fewer than k shares could never recover the secret
+	if (n < k)
+		throw std::domain_error("Error: The number of shares (n) is less than the threshold (k).");
+
+	std::vector<uint64_t> secrets(group.size());
+	for (size_t s = 0; s < group.size(); s++)
+		secrets[s] = group[s]->payload[0];
+
+	BatchDealer dealer(secrets, k, this->randomSource);
+	std::vector<uint64_t> xValues(n);
+	std::iota(xValues.begin(), xValues.end(), 1);
+	dealer.generateShares(xValues);
+
+	std::vector<uint64_t> yValues(n);
+	for (size_t s = 0; s < group.size(); s++) 
+	{
+		for (size_t h = 0; h < n; h++)
+			yValues[h] = dealer.getColumn(h)[s];
+		reply(*group[s], yValues.data(), n);
+	}
+}
+
+
+/**
+ * Recovers every secret in the group with the same Lagrange weights, which 
+ * come from the worker's cache when these holders have been seen before.
+ */
+void CustodyServer::Worker::recover(const Group &group) 
+{
+	const std::vector<uint64_t> &first = group[0]->payload;
+	std::vector<uint64_t> xValues(first.size() / 2), yValues(xValues.size());
+	for (size_t i = 0; i < xValues.size(); i++)
+		xValues[i] = first[2*i];
+
+	std::shared_ptr<const RecoveryPlan> plan = this->plans.get(xValues);
+
+	std::vector<uint64_t> secrets(group.size());
+	for (size_t s = 0; s < group.size(); s++) 
+	{
+		const std::vector<uint64_t> &payload = group[s]->payload;
+		for (size_t i = 0; i < yValues.size(); i++)
+			yValues[i] = payload[2*i + 1];
+
+		// Throws for a y-value outside the field
+		secrets[s] = plan->recover(yValues.data());
+	}
+
+	for (size_t s = 0; s < group.size(); s++)
+		reply(*group[s], &secrets[s], 1);
+}
+
+
+/**
+ * Refreshes every request in the group as one batch, with each holder's 
+ * shares gathered into a column.
+ */
+void CustodyServer::Worker::refresh(const Group &group) 
+{
+	const std::vector<uint64_t> &first = group[0]->payload;
+	uint64_t k = first[0];
+	size_t numHolders = first.size() / 2, numSecrets = group.size();
+
+	std::vector<uint64_t> xValues(numHolders), columns(numHolders * numSecrets);
+	std::vector<uint64_t*> pointers(numHolders);
+	for (size_t h = 0; h < numHolders; h++) 
+	{
+		xValues[h] = first[1 + 2*h];
+		pointers[h] = columns.data() + h * numSecrets;
+		for (size_t s = 0; s < numSecrets; s++)
+			pointers[h][s] = group[s]->payload[2 + 2*h];
+	}
+
+	BatchDealer::refreshShares(xValues, pointers, numSecrets, k, this->randomSource);
+
+	std::vector<uint64_t> yValues(numHolders);
+	for (size_t s = 0; s < numSecrets; s++) 
+	{
+		for (size_t h = 0; h < numHolders; h++)
+			yValues[h] = pointers[h][s];
+		reply(*group[s], yValues.data(), numHolders);
+	}
+}
+
+
+void CustodyServer::Worker::reply(const Job &job, const uint64_t *words, size_t count) 
+{
+	Reply reply{job.connection, {}};
+	CustodyProtocol::Header header = job.header;
+	header.status = static_cast<uint16_t>(CustodyProtocol::Status::Ok);
+	CustodyProtocol::appendFrame(reply.bytes, header, words, static_cast<uint32_t>(count * sizeof(uint64_t)));
+	this->server.postReply(reply);
+}
+
+
+void CustodyServer::Worker::fail(const Job &job, CustodyProtocol::Status status, const std::string &message) 
+{
+	Reply reply{job.connection, {}};
+	appendError(reply.bytes, job.header, status, message);
+	this->server.postReply(reply);
+}
+
+
+/**
+ * The constructor.
+ *  Binds the socket, readable and writable by this user only, and starts the 
+ *  workers. A socket left behind at the path by an earlier run is replaced, 
+ *  but any other kind of file is an error.
+ * 
+ * @param socketPath The path of the Unix domain socket.
+ * @param numWorkers The number of worker threads.
+ */
+CustodyServer::CustodyServer(const std::string &socketPath, unsigned numWorkers) 
+: socketPath(socketPath), jobs(queueCapacity), replies(queueCapacity), nextConnection(stopId + 1) 
+{
+	if (numWorkers < 1)
+		throw std::domain_error("Error: The number of workers is outside the range.");
+
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+		throw std::invalid_argument("Error: The socket path is empty or too long.");
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+	try 
+	{
+		struct stat existing;
+		if (::lstat(socketPath.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+			::unlink(socketPath.c_str());
+
+		this->listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (this->listenFd < 0 || ::bind(this->listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+			throw std::runtime_error("Error: Couldn't bind the socket " + socketPath + ": " + std::strerror(errno));
+		this->bound = true;
+		if (::chmod(socketPath.c_str(), 0600) < 0 || ::listen(this->listenFd, SOMAXCONN) < 0)
+			throw std::runtime_error("Error: Couldn't listen on the socket " + socketPath + ": " + std::strerror(errno));
+
+		this->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+		this->replyFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		this->stopFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (this->epollFd < 0 || this->replyFd < 0 || this->stopFd < 0)
+			throw std::runtime_error(std::string("Error: Couldn't set up the event loop: ") + std::strerror(errno));
+
+		for (auto [fd, id] : {std::make_pair(this->listenFd, listenId), std::make_pair(this->replyFd, replyId), 
+			std::make_pair(this->stopFd, stopId)}) 
+		{
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.u64 = id;
+			if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+				throw std::runtime_error(std::string("Error: Couldn't set up the event loop: ") + std::strerror(errno));
+		}
+	}
+	catch (...) 
+	{
+		release();
+		throw;
+	}
+
+	for (unsigned i = 0; i < numWorkers; i++)
+		this->workers.emplace_back(&CustodyServer::workerLoop, this);
+}
+
+
+CustodyServer::~CustodyServer() 
+{
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		this->stopping = true;
+	}
+	this->wakeWorkers.notify_all();
+	for (std::thread &worker : this->workers)
+		worker.join();
+
+	release();
+}
+
+
+void CustodyServer::release() 
+{
+	for (auto &entry : this->connections)
+		::close(entry.second.fd);
+	this->connections.clear();
+
+	for (int *fd : {&this->listenFd, &this->epollFd, &this->replyFd, &this->stopFd}) 
+	{
+		if (*fd >= 0)
+			::close(*fd);
+		*fd = -1;
+	}
+
+	if (this->bound)
+		::unlink(this->socketPath.c_str());
+	this->bound = false;
+}
+
+
+/**
+ * Runs the event loop until stop() is called.
+ */
+void CustodyServer::run() 
+{
+	epoll_event events[64];
+	while (!this->stopping) 
+	{
+		int count = ::epoll_wait(this->epollFd, events, 64, -1);
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count < 0)
+			throw std::runtime_error(std::string("Error: The event loop failed: ") + std::strerror(errno));
+
+		for (int i = 0; i < count; i++) 
+		{
+			uint64_t id = events[i].data.u64;
+			uint32_t flags = events[i].events;
+
+			if (id == listenId)
+				acceptConnections();
+			else if (id == replyId) 
+			{
+				uint64_t signals;
+				while (::read(this->replyFd, &signals, sizeof(signals)) > 0) {}
+				deliverReplies();
+			}
+			else if (id == stopId)
+				this->stopping = true;
+			else 
+			{
+				if (flags & EPOLLOUT)
+					flushConnection(id);
+				if (flags & (EPOLLIN | EPOLLHUP | EPOLLERR))
+					readConnection(id);
+			}
+		}
+	}
+}
+
+
+/**
+ * Makes run() return. Only writes to an eventfd, so it's safe to call from 
+ * another thread or a signal handler.
+ */
+void CustodyServer::stop() 
+{
+	uint64_t signal = 1;
+	[[maybe_unused]] ssize_t written = ::write(this->stopFd, &signal, sizeof(signal));
+}
+
+
+void CustodyServer::acceptConnections() 
+{
+	while (true) 
+	{
+		int fd = ::accept4(this->listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0 && (errno == EINTR || errno == ECONNABORTED))
+			continue;
+		if (fd < 0)
+			return;
+
+		uint64_t serial = this->nextConnection++;
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.u64 = serial;
+		if (::epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) 
+		{
+			::close(fd);
+			continue;
+		}
+
+		Connection connection;
+		connection.fd = fd;
+		connection.events = event.events;
+		this->connections.emplace(serial, std::move(connection));
+	}
+}
+
+
+/**
+ * Reads whatever a connection has sent and queues every complete request.
+ *  Requests which can't be queued are answered here: an unknown opcode, or 
+ *  Busy when the queue is full. A malformed header closes the connection, 
+ *  since the stream can't be resynchronised after it.
+ * 
+ * @param serial The connection.
+ */
+void CustodyServer::readConnection(uint64_t serial) 
+{
+	auto found = this->connections.find(serial);
+	if (found == this->connections.end())
+		return;
+	Connection &connection = found->second;
+
+	char buffer[1 << 16];
+	while (connection.output.size() - connection.outputSent <= maxPendingOutput) 
+	{
+		ssize_t received = ::read(connection.fd, buffer, sizeof(buffer));
+		if (received > 0) 
+		{
+			connection.input.insert(connection.input.end(), buffer, buffer + received);
+			continue;
+		}
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+
+		// End of stream or an error. Replies still being computed are dropped.
+		closeConnection(serial);
+		return;
+	}
+
+	size_t offset = 0, queued = 0;
+	bool malformed = false;
+	while (connection.input.size() - offset >= sizeof(CustodyProtocol::Header)) 
+	{
+		CustodyProtocol::Header header;
+		std::memcpy(&header, connection.input.data() + offset, sizeof(header));
+		if (header.length > CustodyProtocol::maxPayload || header.length % sizeof(uint64_t) != 0) 
+		{
+			malformed = true;
+			break;
+		}
+		if (connection.input.size() - offset - sizeof(header) < header.length)
+			break;
+
+		const char *payload = connection.input.data() + offset + sizeof(header);
+		offset += sizeof(header) + header.length;
+
+		if (header.opcode < static_cast<uint16_t>(CustodyProtocol::Opcode::Split) || 
+			header.opcode > static_cast<uint16_t>(CustodyProtocol::Opcode::Refresh)) 
+		{
+			appendError(connection.output, header, CustodyProtocol::Status::UnknownOpcode, "Error: Unknown opcode.");
+			continue;
+		}
+
+		Job job{serial, header, std::vector<uint64_t>(header.length / sizeof(uint64_t))};
+		std::memcpy(job.payload.data(), payload, header.length);
+
+		// Counted before it's visible, so a worker never sees fewer jobs than are queued
+		this->pendingJobs++;
+		if (!this->jobs.tryPush(job)) 
+		{
+			this->pendingJobs--;
+			appendError(connection.output, header, CustodyProtocol::Status::Busy, "Error: The server is busy.");
+			continue;
+		}
+		queued++;
+	}
+	connection.input.erase(connection.input.begin(), connection.input.begin() + offset);
+
+	if (queued > 0 && this->sleepingWorkers > 0) 
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		if (queued > 1)
+			this->wakeWorkers.notify_all();
+		else
+			this->wakeWorkers.notify_one();
+	}
+
+	if (malformed)
+		closeConnection(serial);
+	else if (!connection.output.empty())
+		flushConnection(serial);
+	else
+		watchConnection(serial, connection);
+}
+
+
+/**
+ * Writes as much pending output as the socket takes, and waits for it to 
+ * become writable again if that isn't all of it.
+ * 
+ * @param serial The connection.
+ */
+void CustodyServer::flushConnection(uint64_t serial) 
+{
+	auto found = this->connections.find(serial);
+	if (found == this->connections.end())
+		return;
+	Connection &connection = found->second;
+
+	while (connection.outputSent < connection.output.size()) 
+	{
+		ssize_t sent = ::send(connection.fd, connection.output.data() + connection.outputSent, 
+			connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+		if (sent >= 0) 
+		{
+			connection.outputSent += sent;
+			continue;
+		}
+		if (errno == EINTR)
+			continue;
+		if (errno != EAGAIN && errno != EWOULDBLOCK) 
+		{
+			closeConnection(serial);
+			return;
+		}
+
+		connection.waitingToWrite = true;
+		watchConnection(serial, connection);
+		return;
+	}
+
+	connection.output.clear();
+	connection.outputSent = 0;
+	connection.waitingToWrite = false;
+	watchConnection(serial, connection);
+}
+
+
+/**
+ * Sets the events epoll reports for a connection. It waits for the socket to 
+ * be writable while output is blocked, and stops reading requests while more 
+ * than maxPendingOutput is waiting, so a client that pipelines without 
+ * reading the replies can't make the daemon buffer without bound.
+ * 
+ * @param serial The connection.
+ * @param connection Its state.
+ */
+void CustodyServer::watchConnection(uint64_t serial, Connection &connection) 
+{
+	uint32_t events = 0;
+	if (connection.output.size() - connection.outputSent <= maxPendingOutput)
+		events |= EPOLLIN;
+	if (connection.waitingToWrite)
+		events |= EPOLLOUT;
+	if (events == connection.events)
+		return;
+
+	epoll_event event{};
+	event.events = events;
+	event.data.u64 = serial;
+	::epoll_ctl(this->epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+	connection.events = events;
+}
+
+
+void CustodyServer::closeConnection(uint64_t serial) 
+{
+	auto found = this->connections.find(serial);
+	if (found == this->connections.end())
+		return;
+
+	::close(found->second.fd);
+	this->connections.erase(found);
+}
+
+
+/**
+ * Moves the workers' replies onto their connections and writes them. Replies 
+ * for connections which have closed are dropped.
+ */
+void CustodyServer::deliverReplies() 
+{
+	std::vector<uint64_t> ready;
+	Reply reply;
+	while (this->replies.tryPop(reply)) 
+	{
+		auto found = this->connections.find(reply.connection);
+		if (found == this->connections.end())
+			continue;
+
+		// A connection with output already pending is waiting for EPOLLOUT
+		Connection &connection = found->second;
+		if (connection.output.empty())
+			ready.push_back(reply.connection);
+		connection.output.insert(connection.output.end(), reply.bytes.begin(), reply.bytes.end());
+		if (connection.waitingToWrite)
+			watchConnection(reply.connection, connection);
+	}
+
+	for (uint64_t serial : ready)
+		flushConnection(serial);
+}
+
+
+/**
+ * Queues a reply for the event loop. The queue only fills up if the loop is 
+ * far behind, so this waits for it rather than dropping the reply.
+ */
+void CustodyServer::postReply(Reply &reply) 
+{
+	while (!this->replies.tryPush(reply))
+		std::this_thread::yield();
+}
+
+
+/**
+ * Waits until there are jobs to take.
+ *  A worker spins briefly first, since under load the next request is 
+ *  usually only microseconds away, and only then sleeps.
+ * 
+ * @return False once the server is stopping.
+ */
+bool CustodyServer::waitForJobs() 
+{
+	for (int spin = 0; spin < 64; spin++) 
+	{
+		if (this->stopping)
+			return false;
+		if (this->pendingJobs > 0)
+			return true;
+		std::this_thread::yield();
+	}
+
+	std::unique_lock<std::mutex> lock(this->sleepMutex);
+	this->sleepingWorkers++;
+	this->wakeWorkers.wait(lock, [this] { return this->pendingJobs > 0 || this->stopping; });
+	this->sleepingWorkers--;
+	return !this->stopping;
+}
+
+
+void CustodyServer::workerLoop() 
+{
+	Worker worker(*this);
+	std::vector<Job> batch;
+
+	while (waitForJobs()) 
+	{
+		batch.clear();
+		Job job;
+		while (batch.size() < maxBatch && this->jobs.tryPop(job)) 
+		{
+			this->pendingJobs--;
+			batch.push_back(std::move(job));
+		}
+		if (batch.empty())
+			continue;
+
+		worker.process(batch);
+
+		uint64_t signal = 1;
+		[[maybe_unused]] ssize_t written = ::write(this->replyFd, &signal, sizeof(signal));
+	}
+}
@@ -0,0 +1,52 @@
+#include "difference-table.h"
+#include "fp61.h"
+
+
+/**
+ * Builds the table from P(x), P(x+1), ..., P(x+d) in O(d^2) subtractions.
+ *  After pass i, values[j] for j >= i holds the i-th difference at x+j-i.
+ * 
+ * @param firstX The x-value of the first value.
+ * @param values d+1 consecutive values of the degree d polynomial.
+ */
+DifferenceTable::DifferenceTable(uint64_t firstX, const std::vector<uint64_t> &values) 
+: differences(values), nextX(firstX) 
+{
+	size_t d = this->differences.size();
+	for (size_t order = 1; order < d; order++) 
+	{
+		for (size_t j = d-1; j >= order; j--)
+			this->differences[j] = Fp61::sub(this->differences[j], this->differences[j-1]);
+	}
+}
+
+
+bool DifferenceTable::isEmpty() const 
+{
+	return this->differences.empty();
+}
+
+uint64_t DifferenceTable::getNextX() const 
+{
+	return this->nextX;
+}
+
+
+/**
+ * Returns P(nextX) and advances the table to nextX+1.
+ *  Each difference is increased by the one above it, in increasing order so 
+ *  every addition uses the old value of the next difference.
+ * 
+ * @return P(nextX)
+ */
+uint64_t DifferenceTable::next() 
+{
+	uint64_t value = this->differences[0];
+
+	size_t d = this->differences.size();
+	for (size_t i = 0; i+1 < d; i++)
+		this->differences[i] = Fp61::add(this->differences[i], this->differences[i+1]);
+	this->nextX++;
+
+	return value;
+}
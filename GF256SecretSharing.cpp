@@ -0,0 +1,424 @@
+#include "gf256.h"
+
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SSS_GF256_X86 1
+#endif
+
+
+/**
+ * The log/exp tables for GF(2^8) with the AES polynomial x^8+x^4+x^3+x+1 and
+ * the generator 3. exp is doubled so exp[log[a] + log[b]] never needs a mod.
+ */
+struct GF256Tables {
+	uint8_t exp[512];
+	uint8_t log[256];
+
+	GF256Tables()
+	{
+		uint8_t x = 1;
+		for (int i = 0; i < 255; i++) 
+		{
+			exp[i] = exp[i+255] = x;
+			log[x] = static_cast<uint8_t>(i);
+
+			// x *= 3, i.e. x ^= x*2
+			uint8_t doubled = static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+			x ^= doubled;
+		}
+		exp[510] = exp[511] = exp[0];
+		log[0] = 0;
+	}
+};
+
+static const GF256Tables tables;
+
+
+uint8_t GF256SecretSharing::multiply(uint8_t a, uint8_t b) 
+{
+	if (a == 0 || b == 0)
+		return 0;
+	return tables.exp[tables.log[a] + tables.log[b]];
+}
+
+uint8_t GF256SecretSharing::getMultiplicativeInverse(uint8_t a) 
+{
+	if (a == 0)
+		throw std::invalid_argument("Error: 0 has no multiplicative inverse.");
+	return tables.exp[255 - tables.log[a]];
+}
+
+
+/**
+ * The bulk kernels. Both use the split-nibble form of multiplication by c:
+ *  c*v = c*(v & 0x0F) ^ c*(v & 0xF0), so two 16-entry tables cover every byte
+ *  and a SIMD byte shuffle can look up 16 or 32 bytes at once.
+ * 
+ *  mulAdd:     dst = dst ^ c*src   (accumulating Lagrange terms)
+ *  hornerStep: dst = c*dst ^ src   (one step of Horner's scheme)
+ */
+using RegionKernel = void (*)(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+
+static void makeNibbleTables(uint8_t c, uint8_t low[16], uint8_t high[16]) 
+{
+	for (int i = 0; i < 16; i++) 
+	{
+		low[i] = GF256SecretSharing::multiply(c, static_cast<uint8_t>(i));
+		high[i] = GF256SecretSharing::multiply(c, static_cast<uint8_t>(i << 4));
+	}
+}
+
+static void mulAddScalar(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) 
+{
+	uint8_t low[16], high[16];
+	makeNibbleTables(c, low, high);
+	for (size_t i = 0; i < len; i++)
+		dst[i] ^= low[src[i] & 0x0F] ^ high[src[i] >> 4];
+}
+
+static void hornerStepScalar(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) 
+{
+	uint8_t low[16], high[16];
+	makeNibbleTables(c, low, high);
+	for (size_t i = 0; i < len; i++)
+		dst[i] = low[dst[i] & 0x0F] ^ high[dst[i] >> 4] ^ src[i];
+}
+
+#ifdef SSS_GF256_X86
+__attribute__((target("ssse3")))
+static inline __m128i mulSSSE3(__m128i v, __m128i low, __m128i high, __m128i mask) 
+{
+	__m128i lowNibbles = _mm_and_si128(v, mask);
+	__m128i highNibbles = _mm_and_si128(_mm_srli_epi64(v, 4), mask);
+	return _mm_xor_si128(_mm_shuffle_epi8(low, lowNibbles), _mm_shuffle_epi8(high, highNibbles));
+}
+
+__attribute__((target("ssse3")))
+static void mulAddSSSE3(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) 
+{
+	uint8_t lowTable[16], highTable[16];
+	makeNibbleTables(c, lowTable, highTable);
+	__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lowTable));
+	__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(highTable));
+	__m128i mask = _mm_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) 
+	{
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(d, mulSSSE3(s, low, high, mask)));
+	}
+	mulAddScalar(dst + i, src + i, c, len - i);
+}
+
+__attribute__((target("ssse3")))
+static void hornerStepSSSE3(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) 
+{
+	uint8_t lowTable[16], highTable[16];
+	makeNibbleTables(c, lowTable, highTable);
+	__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lowTable));
+	__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(highTable));
+	__m128i mask = _mm_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) 
+	{
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(mulSSSE3(d, low, high, mask), s));
+	}
+	hornerStepScalar(dst + i, src + i, c, len - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mulAVX2(__m256i v, __m256i low, __m256i high, __m256i mask) 
+{
+	__m256i lowNibbles = _mm256_and_si256(v, mask);
+	__m256i highNibbles = _mm256_and_si256(_mm256_srli_epi64(v, 4), mask);
+	return _mm256_xor_si256(_mm256_shuffle_epi8(low, lowNibbles), _mm256_shuffle_epi8(high, highNibbles));
+}
+
+__attribute__((target("avx2")))
+static void mulAddAVX2(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) 
+{
+	uint8_t lowTable[16], highTable[16];
+	makeNibbleTables(c, lowTable, highTable);
+
+	// The shuffle only looks within each 128-bit lane, so both lanes get the tables
+	__m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lowTable)));
+	__m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(highTable)));
+	__m256i mask = _mm256_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) 
+	{
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(d, mulAVX2(s, low, high, mask)));
+	}
+	mulAddScalar(dst + i, src + i, c, len - i);
+}
+
+__attribute__((target("avx2")))
+static void hornerStepAVX2(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) 
+{
+	uint8_t lowTable[16], highTable[16];
+	makeNibbleTables(c, lowTable, highTable);
+	__m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lowTable)));
+	__m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(highTable)));
+	__m256i mask = _mm256_set1_epi8(0x0F);
+
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) 
+	{
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(mulAVX2(d, low, high, mask), s));
+	}
+	hornerStepScalar(dst + i, src + i, c, len - i);
+}
+#endif
+
+
+static bool isSupported(GF256SecretSharing::Kernel kernel) 
+{
+#ifdef SSS_GF256_X86
+	// Needed because this also runs during static initialisation
+	__builtin_cpu_init();
+	if (kernel == GF256SecretSharing::Kernel::AVX2)
+		return __builtin_cpu_supports("avx2");
+	if (kernel == GF256SecretSharing::Kernel::SSSE3)
+		return __builtin_cpu_supports("ssse3");
+#endif
+	return kernel == GF256SecretSharing::Kernel::Scalar;
+}
+
+static GF256SecretSharing::Kernel bestKernel() 
+{
+	if (isSupported(GF256SecretSharing::Kernel::AVX2))
+		return GF256SecretSharing::Kernel::AVX2;
+	if (isSupported(GF256SecretSharing::Kernel::SSSE3))
+		return GF256SecretSharing::Kernel::SSSE3;
+	return GF256SecretSharing::Kernel::Scalar;
+}
+
+static GF256SecretSharing::Kernel activeKernel = bestKernel();
+
+static RegionKernel mulAddKernel() 
+{
+#ifdef SSS_GF256_X86
+	if (activeKernel == GF256SecretSharing::Kernel::AVX2)
+		return mulAddAVX2;
+	if (activeKernel == GF256SecretSharing::Kernel::SSSE3)
+		return mulAddSSSE3;
+#endif
+	return mulAddScalar;
+}
+
+static RegionKernel hornerStepKernel() 
+{
+#ifdef SSS_GF256_X86
+	if (activeKernel == GF256SecretSharing::Kernel::AVX2)
+		return hornerStepAVX2;
+	if (activeKernel == GF256SecretSharing::Kernel::SSSE3)
+		return hornerStepSSSE3;
+#endif
+	return hornerStepScalar;
+}
+
+
+GF256SecretSharing::Kernel GF256SecretSharing::getKernel() 
+{
+	return activeKernel;
+}
+
+
+/**
+ * Overrides the kernel chosen for this CPU, e.g. to compare against the scalar
+ * fallback. It isn't synchronised, so call it before sharing starts.
+ * 
+ * @param kernel The kernel to use.
+ * 
+ * @return False if this CPU doesn't support the kernel, which leaves it unchanged.
+ */
+bool GF256SecretSharing::setKernel(Kernel kernel) 
+{
+	if (!isSupported(kernel))
+		return false;
+
+	activeKernel = kernel;
+	return true;
+}
+
+
+/**
+ * The constructor.
+ *  Given a secret and threshold, it immediately generates a degree k-1 
+ *  polynomial for every byte of the secret. The coefficients come from 
+ *  randomSource, or a new ChaCha20Rng if it's null.
+ */
+GF256SecretSharing::GF256SecretSharing(const std::vector<uint8_t> &secret, uint64_t threshold, 
+	std::shared_ptr<RandomSource> randomSource) 
+: threshold(threshold), randomSource(std::move(randomSource)) 
+{
+	if (threshold < 2 || threshold > 255)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+	if (!this->randomSource)
+		this->randomSource = std::make_shared<ChaCha20Rng>();
+
+	// Immediately hide the secret in the degree k-1 polynomials.
+	generateCoefficients(secret);
+}
+
+
+uint64_t GF256SecretSharing::getNumShares() const 
+{
+	return this->shares.size();
+}
+
+uint64_t GF256SecretSharing::getThreshold() const 
+{
+	return this->threshold;
+}
+
+const std::vector<ByteShare>& GF256SecretSharing::getShares() const 
+{
+	return this->shares;
+}
+
+
+/**
+ * Generates n additional shares, with x-values continuing from the last share.
+ * 
+ * @param numToGenerate The number of new shares to create.
+ */
+void GF256SecretSharing::generateAdditionalShares(uint64_t numToGenerate) 
+{
+	size_t prevSize = this->shares.size();
+	if (numToGenerate > 255-prevSize)
+		throw std::domain_error("Error: The number of shares requested is outside the range.");
+
+	this->shares.reserve(prevSize + numToGenerate);
+	for (uint64_t i = 0; i < numToGenerate; i++) 
+	{
+		uint8_t x = static_cast<uint8_t>(prevSize + i + 1);
+		this->shares.push_back({x, evaluatePolynomials(x)});
+	}
+}
+
+
+/**
+ * Uses the Lagrange Interpolation Formula to recover the secret, byte by byte.
+ *  In GF(2^8) subtraction is XOR, so the weight of share i at x=0 is
+ *  w_{i} = (x_{1}...x_{i-1}x_{i+1}...x_{k}) / ((x_{i}^x_{1})...(x_{i}^x_{k})).
+ *  Each weighted share is then accumulated with the bulk kernel.
+ * 
+ * @param userShares The list of shares to interpolate.
+ * 
+ * @return The secret bytes.
+ */
+std::vector<uint8_t> GF256SecretSharing::recoverSecret(const std::vector<ByteShare> &userShares) 
+{
+	if (userShares.empty())
+		return {};
+
+	size_t length = userShares[0].y.size();
+	bool seen[256] = {};
+	for (const ByteShare &share : userShares) 
+	{
+		if (share.x == 0)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+		if (share.y.size() != length)
+			throw std::invalid_argument("Error: The provided shares have different lengths.");
+		if (seen[share.x])
+			throw std::invalid_argument("Error: Two or more of the provided shares had the same x-value.");
+		seen[share.x] = true;
+	}
+
+	RegionKernel mulAdd = mulAddKernel();
+	std::vector<uint8_t> secret(length, 0);
+
+	for (const ByteShare &si : userShares) 
+	{
+		uint8_t numerator = 1, denominator = 1;
+		for (const ByteShare &sj : userShares) 
+		{
+			if (si.x == sj.x)
+				continue;
+			numerator = multiply(numerator, sj.x);
+			denominator = multiply(denominator, si.x ^ sj.x);
+		}
+
+		uint8_t weight = multiply(numerator, getMultiplicativeInverse(denominator));
+		mulAdd(secret.data(), si.y.data(), weight, length);
+	}
+
+	return secret;
+}
+
+
+/**
+ * Generates k-1 rows of random coefficients. The last row is non-zero so every
+ * byte's polynomial has degree k-1.
+ * 
+ * @param secret The secret, which becomes row 0.
+ */
+void GF256SecretSharing::generateCoefficients(const std::vector<uint8_t> &secret) 
+{
+	this->coefficients.assign(this->threshold, std::vector<uint8_t>(secret.size()));
+	this->coefficients[0] = secret;
+
+	// Each 64-bit word supplies 8 coefficients, and a row's words are drawn in one go
+	std::vector<uint64_t> words;
+	for (size_t j = 1; j < this->threshold; j++) 
+	{
+		std::vector<uint8_t> &row = this->coefficients[j];
+		bool nonZero = j+1 == this->threshold;
+
+		words.resize((row.size() + 7) / 8);
+		this->randomSource->fill(words.data(), words.size());
+
+		uint64_t bits = 0;
+		int bytesLeft = 0;
+		size_t nextWord = 0;
+		for (size_t b = 0; b < row.size();)
+		{
+			if (bytesLeft == 0)
+			{
+				// Rejected zeros in the leading row can use up the batch
+				bits = nextWord < words.size() ? words[nextWord++] : (*this->randomSource)();
+				bytesLeft = 8;
+			}
+			uint8_t coefficient = static_cast<uint8_t>(bits);
+			bits >>= 8;
+			bytesLeft--;
+
+			// Zero is rejected in the leading row
+			if (nonZero && coefficient == 0)
+				continue;
+			row[b++] = coefficient;
+		}
+	}
+}
+
+
+/**
+ * Evaluates every byte's polynomial at x with Horner's scheme.
+ * 
+ * @param x The x-value.
+ * 
+ * @return The y-bytes.
+ */
+std::vector<uint8_t> GF256SecretSharing::evaluatePolynomials(uint8_t x) const 
+{
+	RegionKernel hornerStep = hornerStepKernel();
+	std::vector<uint8_t> yValues(this->coefficients[this->threshold-1]);
+
+	for (size_t j = this->threshold-1; j-- > 0;)
+		hornerStep(yValues.data(), this->coefficients[j].data(), x, yValues.size());
+
+	return yValues;
+}
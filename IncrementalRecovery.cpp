@@ -0,0 +1,142 @@
+#include "incremental-recovery.h"
+#include "fp61.h"
+
+#include <stdexcept>
+
+
+/**
+ * The constructor.
+ *
+ * @param threshold The number of shares needed to recover the secret (k).
+ */
+IncrementalRecovery::IncrementalRecovery(uint64_t threshold)
+: threshold(threshold)
+{
+	if (threshold < 2 || threshold > Fp61::p-1)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+
+	this->xValues.reserve(threshold);
+	this->yValues.reserve(threshold);
+	this->denominators.reserve(threshold);
+}
+
+
+uint64_t IncrementalRecovery::getThreshold() const
+{
+	return this->threshold;
+}
+
+size_t IncrementalRecovery::getNumShares() const
+{
+	return this->xValues.size();
+}
+
+bool IncrementalRecovery::isComplete() const
+{
+	return this->xValues.size() >= this->threshold;
+}
+
+
+/**
+ * Adds a share. Every existing d_{i} gains the factor (x - x_{i}), and the
+ * new share's d is the product of (x_{i} - x), all in one pass.
+ *
+ * @param share The share, with x in [1, p) and y in [0, p).
+ *
+ * @return True if there are now at least k shares.
+ */
+bool IncrementalRecovery::addShare(const Share &share)
+{
+	const auto &[x, y] = share;
+	if (x < 1 || x > Fp61::p-1 || y > Fp61::p-1)
+		throw std::domain_error("Error: A provided share is outside the field range.");
+	if (this->indices.count(x))
+		throw std::invalid_argument("Error: Two or more of the provided shares had the same x-value.");
+
+	uint64_t denominator = 1;
+	for (size_t i = 0; i < this->xValues.size(); i++)
+	{
+		uint64_t difference = Fp61::sub(x, this->xValues[i]);
+		this->denominators[i] = Fp61::mul(this->denominators[i], difference);
+		denominator = Fp61::mul(denominator, Fp61::neg(difference));
+	}
+
+	this->indices.emplace(x, this->xValues.size());
+	this->xValues.push_back(x);
+	this->yValues.push_back(y);
+	this->denominators.push_back(denominator);
+	this->numerator = Fp61::mul(this->numerator, x);
+
+	return isComplete();
+}
+
+
+/**
+ * Removes the share at x, for instance one found to be from the wrong holder.
+ *  The factors (x - x_{i}) are divided back out of every d_{i}, with one batch
+ *  inversion that also covers x itself for the numerator.
+ *
+ * @param x The x-value of the share to remove.
+ *
+ * @return False if no share had that x-value.
+ */
+bool IncrementalRecovery::removeShare(uint64_t x)
+{
+	auto found = this->indices.find(x);
+	if (found == this->indices.end())
+		return false;
+
+	size_t removed = found->second;
+	this->indices.erase(found);
+
+	// Move the last share into the hole, so the rest stay contiguous
+	size_t last = this->xValues.size() - 1;
+	if (removed != last)
+	{
+		this->xValues[removed] = this->xValues[last];
+		this->yValues[removed] = this->yValues[last];
+		this->denominators[removed] = this->denominators[last];
+		this->indices[this->xValues[removed]] = removed;
+	}
+	this->xValues.pop_back();
+	this->yValues.pop_back();
+	this->denominators.pop_back();
+
+	// factors[i] = x - x_{i}, and x at the end
+	std::vector<uint64_t> factors(this->xValues.size() + 1);
+	for (size_t i = 0; i < this->xValues.size(); i++)
+		factors[i] = Fp61::sub(x, this->xValues[i]);
+	factors.back() = x;
+	Fp61::batchInv(factors);
+
+	for (size_t i = 0; i < this->xValues.size(); i++)
+		this->denominators[i] = Fp61::mul(this->denominators[i], factors[i]);
+	this->numerator = Fp61::mul(this->numerator, factors.back());
+
+	return true;
+}
+
+
+/**
+ * Combines the shares added so far.
+ *  secret = x_{1}...x_{m} * sum y_{i} / (x_{i} * d_{i}), with the m values x_{i} * d_{i}
+ *  inverted together.
+ *
+ * @return The secret.
+ */
+uint64_t IncrementalRecovery::getSecret() const
+{
+	if (!isComplete())
+		throw std::domain_error("Error: Fewer than k shares have been added.");
+
+	std::vector<uint64_t> weights(this->xValues.size());
+	for (size_t i = 0; i < weights.size(); i++)
+		weights[i] = Fp61::mul(this->xValues[i], this->denominators[i]);
+	Fp61::batchInv(weights);
+
+	Fp61::Accumulator sum;
+	for (size_t i = 0; i < weights.size(); i++)
+		sum.addProduct(this->yValues[i], weights[i]);
+
+	return Fp61::mul(this->numerator, sum.value());
+}
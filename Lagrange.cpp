@@ -0,0 +1,327 @@
+#include "lagrange.h"
+#include "fp61.h"
+#include "polynomial.h"
+#include "polynomial-evaluator.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+
+std::vector<uint64_t> Lagrange::factorials = {1};
+std::vector<uint64_t> Lagrange::inverseFactorials = {1};
+std::shared_mutex Lagrange::factorialMutex;
+
+
+/**
+ * Computes the Lagrange weights at x=0, so that P(0) = w_{1}y_{1} + ... + w_{k}y_{k}.
+ * 
+ * w_{i} = ((0-x_{1})...(0-x_{i-1})(0-x_{i+1})...(0-x_{k})) /
+ *             ((x_{i}-x_{1})...(x_{i}-x_{i-1})(x_{i}-x_{i+1})...(x_{i}-x_{k}))
+ * 
+ *       = N / ((0-x_{i}) * D_{i}), where N = (0-x_{1})...(0-x_{k})
+ * 
+ * All k denominators (0-x_{i}) * D_{i} are inverted together with one field
+ * inversion, so the cost is dominated by the k(k-1) multiplications for D_{i}.
+ * Those run in SIMD lanes, and with a thread pool the rows are split between 
+ * the threads. Field arithmetic is exact, so the weights are the same however 
+ * the work is divided. When the x-values are an arithmetic progression the 
+ * closed form is used instead, which takes O(k).
+ * 
+ * @param xValues The x-values of the shares. Must be in [1, p-1] and unique.
+ * @param pool Threads to share the work between, or null.
+ * 
+ * @return The weights w_{1}, ..., w_{k}, in the same order as xValues.
+ */
+std::vector<uint64_t> Lagrange::weightsAtZero(const std::vector<uint64_t> &xValues, ThreadPool *pool) 
+{
+	uint64_t first, step;
+	if (isArithmeticProgression(xValues, first, step))
+		return weightsAtZeroArithmetic(first, step, xValues.size());
+
+	checkUnique(xValues);
+
+	size_t k = xValues.size();
+	if (k >= fastInterpolationThreshold)
+		return weightsAtZeroFast(xValues, pool);
+
+	std::vector<uint64_t> weights(k);
+
+	// N = (0-x_{1})...(0-x_{k}), as the differences from the point 0
+	uint64_t zero = 0, numerator;
+	PolynomialEvaluator::productsOfDifferences(xValues.data(), k, &zero, &numerator, 1);
+
+	// D_{i} = (x_{i}-x_{1})...(x_{i}-x_{k}) skipping j=i. x-values are unique, 
+	// so x_{i}-x_{j} is only 0 when j=i, and that factor counts as 1.
+	auto denominators = [&](size_t begin, size_t end)
+	{
+		PolynomialEvaluator::productsOfDifferences(xValues.data(), k, xValues.data() + begin, weights.data() + begin, end - begin);
+		for (size_t i = begin; i < end; i++)
+			weights[i] = Fp61::mul(Fp61::neg(xValues[i]), weights[i]);
+	};
+	if (pool)
+		pool->parallelFor(k, denominators);
+	else
+		denominators(0, k);
+
+	// w_{i} = N * ((0-x_{i}) * D_{i})^{-1}
+	Fp61::batchInv(weights);
+	for (size_t i = 0; i < k; i++)
+		weights[i] = Fp61::mul(numerator, weights[i]);
+
+	return weights;
+}
+
+
+/**
+ * Computes the Lagrange weights at x=0 like weightsAtZero, but finds the 
+ * denominators with a subproduct tree: D_{i} = M'(x_{i}), where 
+ * M = (x - x_{1})...(x - x_{k}). Building M and evaluating M' at every x_{i} 
+ * both take O(M(k) log k), where M(k) is the cost of a Karatsuba 
+ * multiplication, instead of the k(k-1) multiplications of the direct form.
+ * 
+ * @param xValues The x-values of the shares. Must be in [1, p-1] and unique.
+ * @param pool Threads to share the subproduct tree between, or null.
+ * 
+ * @return The weights w_{1}, ..., w_{k}, in the same order as xValues.
+ */
+std::vector<uint64_t> Lagrange::weightsAtZeroFast(const std::vector<uint64_t> &xValues, ThreadPool *pool) 
+{
+	size_t k = xValues.size();
+	std::vector<uint64_t> weights = Polynomial::derivativeAtRoots(xValues, pool);
+
+	// N = (0-x_{1})...(0-x_{k})
+	uint64_t numerator = 1;
+	for (size_t i = 0; i < k; i++) 
+	{
+		numerator = Fp61::mul(numerator, Fp61::neg(xValues[i]));
+		weights[i] = Fp61::mul(Fp61::neg(xValues[i]), weights[i]);
+	}
+
+	// w_{i} = N * ((0-x_{i}) * D_{i})^{-1}
+	Fp61::batchInv(weights);
+	for (size_t i = 0; i < k; i++)
+		weights[i] = Fp61::mul(numerator, weights[i]);
+
+	return weights;
+}
+
+
+/**
+ * Computes the Lagrange weights at x=0 for x_{i} = first + i*step, i = 0..k-1.
+ *  Here x_{i}-x_{j} = (i-j)*step, so the denominator has a closed form:
+ * 
+ *    D_{i} = step^{k-1} * i! * (-1)^{k-1-i} * (k-1-i)!
+ * 
+ *  and the numerator (0-x_{0})...(0-x_{k-1}) without x_{i} is 
+ *  (-1)^{k-1} times the prefix product x_{0}...x_{i-1} and the suffix 
+ *  product x_{i+1}...x_{k-1}. Altogether:
+ * 
+ *    w_{i} = (-1)^{i} * prefix_{i} * suffix_{i} * step^{-(k-1)} / (i! (k-1-i)!)
+ * 
+ *  which needs O(k) multiplications, the factorial tables and one inversion.
+ * 
+ * @param first The first x-value, in [1, p-1].
+ * @param step The non-zero common difference (mod p).
+ * @param k The number of x-values, none of which may be 0 (mod p).
+ * 
+ * @return The weights w_{0}, ..., w_{k-1}.
+ */
+std::vector<uint64_t> Lagrange::weightsAtZeroArithmetic(uint64_t first, uint64_t step, size_t k) 
+{
+	if (k == 0)
+		return {};
+
+	std::vector<uint64_t> xValues(k);
+	xValues[0] = first;
+	for (size_t i = 1; i < k; i++)
+		xValues[i] = Fp61::add(xValues[i-1], step);
+
+	// weights[i] = prefix_{i} for now
+	std::vector<uint64_t> weights(k);
+	uint64_t prefix = 1;
+	for (size_t i = 0; i < k; i++) 
+	{
+		weights[i] = prefix;
+		prefix = Fp61::mul(prefix, xValues[i]);
+	}
+
+	growFactorials(k);
+	std::shared_lock<std::shared_mutex> lock(factorialMutex);
+
+	uint64_t scale = Fp61::inv(Fp61::pow(step, k-1));
+	uint64_t suffix = 1;
+	for (size_t i = k; i-- > 0;) 
+	{
+		uint64_t weight = Fp61::mul(Fp61::mul(weights[i], suffix), scale);
+		weight = Fp61::mul(weight, Fp61::mul(inverseFactorials[i], inverseFactorials[k-1-i]));
+		weights[i] = (i & 1) ? Fp61::neg(weight) : weight;
+		suffix = Fp61::mul(suffix, xValues[i]);
+	}
+
+	return weights;
+}
+
+
+/**
+ * Evaluates the polynomial through (x_{1}, y_{1}), ..., (x_{k}, y_{k}) at 
+ * many target x-values, without going through P(0).
+ * 
+ *    P(t) = sum_{i} c_{i} * prod_{j != i} (t - x_{j}), where c_{i} = y_{i} / D_{i}
+ * 
+ * The c_{i} only depend on the shares, so they are found once, with the same 
+ * k(k-1) multiplications and single inversion as weightsAtZero. Each target 
+ * then takes O(k): the products skipping j = i are a prefix product times a 
+ * suffix product, so no target needs an inversion, and a target equal to 
+ * some x_{i} gives y_{i} without a special case. Altogether O(k(k+m)) for m 
+ * targets, which are split between the threads of a pool.
+ * 
+ * @param xValues The x-values of the shares, at least one. Must be in [1, p-1] and unique.
+ * @param yValues The y-values of the shares, in the same order.
+ * @param targets The x-values to evaluate at.
+ * @param pool Threads to share the work between, or null.
+ * 
+ * @return P(t) for each target t, in the same order as targets.
+ */
+std::vector<uint64_t> Lagrange::evaluateAt(const std::vector<uint64_t> &xValues, const std::vector<uint64_t> &yValues, 
+	const std::vector<uint64_t> &targets, ThreadPool *pool) 
+{
+	if (xValues.size() != yValues.size())
+		throw std::invalid_argument("Error: The number of y-values doesn't match the number of x-values.");
+	if (xValues.empty())
+		throw std::invalid_argument("Error: No shares were provided to interpolate through.");
+
+	checkUnique(xValues);
+
+	// c_{i} = y_{i} * D_{i}^{-1}, with D_{i} = (x_{i}-x_{1})...(x_{i}-x_{k}) skipping j=i
+	size_t k = xValues.size();
+	std::vector<uint64_t> coefficients;
+	if (k >= fastInterpolationThreshold)
+	{
+		coefficients = Polynomial::derivativeAtRoots(xValues, pool);
+	}
+	else
+	{
+		coefficients.resize(k);
+		auto denominators = [&](size_t begin, size_t end)
+		{
+			PolynomialEvaluator::productsOfDifferences(xValues.data(), k, xValues.data() + begin, coefficients.data() + begin, end - begin);
+		};
+		if (pool)
+			pool->parallelFor(k, denominators);
+		else
+			denominators(0, k);
+	}
+
+	Fp61::batchInv(coefficients);
+	for (size_t i = 0; i < k; i++)
+		coefficients[i] = Fp61::mul(yValues[i], coefficients[i]);
+
+	std::vector<uint64_t> values(targets.size());
+	auto evaluate = [&](size_t begin, size_t end)
+	{
+		// suffix[i] = (t-x_{i+1})...(t-x_{k}), then walked forwards with the prefix
+		std::vector<uint64_t> suffix(k);
+		for (size_t target = begin; target < end; target++)
+		{
+			uint64_t t = targets[target], running = 1;
+			for (size_t i = k; i-- > 0;)
+			{
+				suffix[i] = running;
+				running = Fp61::mul(running, Fp61::sub(t, xValues[i]));
+			}
+
+			Fp61::Accumulator sum;
+			uint64_t prefix = 1;
+			for (size_t i = 0; i < k; i++)
+			{
+				sum.addProduct(coefficients[i], Fp61::mul(prefix, suffix[i]));
+				prefix = Fp61::mul(prefix, Fp61::sub(t, xValues[i]));
+			}
+			values[target] = sum.value();
+		}
+	};
+	if (pool)
+		pool->parallelFor(targets.size(), evaluate);
+	else
+		evaluate(0, targets.size());
+
+	return values;
+}
+
+
+/**
+ * Checks whether the x-values are first, first+step, first+2*step, ... (mod p)
+ * for a non-zero step, which also means they are unique. O(k).
+ * 
+ * @param xValues The x-values, in [0, p).
+ * @param first Set to the first x-value.
+ * @param step Set to the common difference.
+ * 
+ * @return True if they are an arithmetic progression.
+ */
+bool Lagrange::isArithmeticProgression(const std::vector<uint64_t> &xValues, uint64_t &first, uint64_t &step) 
+{
+	if (xValues.empty())
+		return false;
+
+	first = xValues[0];
+	step = xValues.size() > 1 ? Fp61::sub(xValues[1], xValues[0]) : 1;
+	if (step == 0)
+		return false;
+
+	for (size_t i = 1; i < xValues.size(); i++) 
+	{
+		if (xValues[i] != Fp61::add(xValues[i-1], step))
+			return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * Makes sure the factorial tables cover 0! to (size-1)!.
+ *  The tables at least double when they grow, and the inverses are filled in 
+ *  from the top with a single inversion: (i-1)!^{-1} = i!^{-1} * i.
+ * 
+ * @param size The number of entries needed.
+ */
+void Lagrange::growFactorials(size_t size) 
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(factorialMutex);
+		if (factorials.size() >= size)
+			return;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(factorialMutex);
+	size_t oldSize = factorials.size();
+	if (oldSize >= size)
+		return;
+
+	size_t newSize = std::max(size, 2*oldSize);
+	factorials.resize(newSize);
+	inverseFactorials.resize(newSize);
+	for (size_t i = oldSize; i < newSize; i++)
+		factorials[i] = Fp61::mul(factorials[i-1], i);
+
+	inverseFactorials[newSize-1] = Fp61::inv(factorials[newSize-1]);
+	for (size_t i = newSize-1; i > oldSize; i--)
+		inverseFactorials[i-1] = Fp61::mul(inverseFactorials[i], i);
+}
+
+
+/**
+ * Checks that no two x-values are equal by sorting a copy, O(k log k).
+ * 
+ * @param xValues The x-values of the shares.
+ */
+void Lagrange::checkUnique(const std::vector<uint64_t> &xValues) 
+{
+	std::vector<uint64_t> sorted(xValues);
+	std::sort(sorted.begin(), sorted.end());
+
+	if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+		throw std::invalid_argument("Error: Two or more of the provided shares had the same x-value.");
+}
@@ -0,0 +1,472 @@
+#include "polynomial.h"
+#include "fp61.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+void Polynomial::trim(Coefficients &f) 
+{
+	while (!f.empty() && f.back() == 0)
+		f.pop_back();
+}
+
+
+/**
+ * Multiplies two polynomials of n coefficients each into 2n-1 coefficients.
+ *  Karatsuba splits each into a low half and a high half and needs three 
+ *  half-size products instead of four:
+ * 
+ *    (a0 + a1 x^h)(b0 + b1 x^h) = z0 + (z1 - z0 - z2) x^h + z2 x^{2h}
+ *    where z0 = a0 b0, z2 = a1 b1 and z1 = (a0 + a1)(b0 + b1)
+ * 
+ *  Small products are done directly, summing each output lazily.
+ */
+void Polynomial::multiplyKaratsuba(const uint64_t *a, const uint64_t *b, size_t n, uint64_t *result) 
+{
+	if (n <= karatsubaThreshold) 
+	{
+		for (size_t i = 0; i < 2*n-1; i++) 
+		{
+			Fp61::Accumulator sum;
+			size_t lo = i < n ? 0 : i-n+1, hi = std::min(i, n-1);
+			for (size_t j = lo; j <= hi; j++)
+				sum.addProduct(a[j], b[i-j]);
+			result[i] = sum.value();
+		}
+		return;
+	}
+
+	size_t h = n/2, high = n-h;
+
+	// a0 + a1 and b0 + b1, with the shorter low half padded
+	std::vector<uint64_t> aSum(a + h, a + n), bSum(b + h, b + n);
+	for (size_t i = 0; i < h; i++) 
+	{
+		aSum[i] = Fp61::add(aSum[i], a[i]);
+		bSum[i] = Fp61::add(bSum[i], b[i]);
+	}
+
+	std::vector<uint64_t> z0(2*h-1), z1(2*high-1), z2(2*high-1);
+	multiplyKaratsuba(a, b, h, z0.data());
+	multiplyKaratsuba(a + h, b + h, high, z2.data());
+	multiplyKaratsuba(aSum.data(), bSum.data(), high, z1.data());
+
+	std::fill(result, result + 2*n-1, 0);
+	for (size_t i = 0; i < z0.size(); i++) 
+	{
+		result[i] = Fp61::add(result[i], z0[i]);
+		z1[i] = Fp61::sub(z1[i], z0[i]);
+	}
+	for (size_t i = 0; i < z2.size(); i++) 
+	{
+		result[i + 2*h] = Fp61::add(result[i + 2*h], z2[i]);
+		z1[i] = Fp61::sub(z1[i], z2[i]);
+	}
+	for (size_t i = 0; i < z1.size(); i++)
+		result[i + h] = Fp61::add(result[i + h], z1[i]);
+}
+
+
+/**
+ * Multiplies two polynomials. Unbalanced products are done in chunks of the 
+ * shorter polynomial's size so Karatsuba always sees equal lengths.
+ *  With a thread pool, a large product takes one Karatsuba step here and 
+ *  its three half-size products run in parallel.
+ * 
+ * @return a*b
+ */
+Polynomial::Coefficients Polynomial::multiply(const Coefficients &a, const Coefficients &b, ThreadPool *pool) 
+{
+	if (a.empty() || b.empty())
+		return {};
+
+	if (pool && pool->size() > 1 && std::min(a.size(), b.size()) >= parallelThreshold) 
+	{
+		size_t h = (std::max(a.size(), b.size()) + 1) / 2;
+		auto low = [h](const Coefficients &f) { return Coefficients(f.begin(), f.begin() + std::min(h, f.size())); };
+		auto high = [h](const Coefficients &f) { return f.size() > h ? Coefficients(f.begin() + h, f.end()) : Coefficients(); };
+
+		Coefficients halves[3][2] = {{low(a), low(b)}, {high(a), high(b)}, {low(a), low(b)}};
+		for (int side = 0; side < 2; side++) 
+		{
+			Coefficients &sum = halves[2][side];
+			const Coefficients &top = halves[1][side];
+			sum.resize(std::max(sum.size(), top.size()), 0);
+			for (size_t i = 0; i < top.size(); i++)
+				sum[i] = Fp61::add(sum[i], top[i]);
+		}
+
+		// z0 = a0 b0, z2 = a1 b1 and z1 = (a0 + a1)(b0 + b1)
+		Coefficients z[3];
+		pool->parallelFor(3, [&](size_t begin, size_t end)
+		{
+			for (size_t t = begin; t < end; t++)
+				z[t] = multiply(halves[t][0], halves[t][1]);
+		});
+
+		// Every product has fewer than 2h coefficients, and the terms above a*b cancel out
+		Coefficients result(4*h, 0);
+		for (size_t i = 0; i < z[0].size(); i++) 
+		{
+			result[i] = Fp61::add(result[i], z[0][i]);
+			result[i + h] = Fp61::sub(result[i + h], z[0][i]);
+		}
+		for (size_t i = 0; i < z[1].size(); i++) 
+		{
+			result[i + 2*h] = Fp61::add(result[i + 2*h], z[1][i]);
+			result[i + h] = Fp61::sub(result[i + h], z[1][i]);
+		}
+		for (size_t i = 0; i < z[2].size(); i++)
+			result[i + h] = Fp61::add(result[i + h], z[2][i]);
+
+		trim(result);
+		return result;
+	}
+
+	const Coefficients &shorter = a.size() <= b.size() ? a : b;
+	const Coefficients &longer = a.size() <= b.size() ? b : a;
+	size_t n = shorter.size();
+
+	Coefficients result(a.size() + b.size() - 1, 0);
+	std::vector<uint64_t> chunk(n), product(2*n-1);
+	for (size_t offset = 0; offset < longer.size(); offset += n) 
+	{
+		size_t length = std::min(n, longer.size() - offset);
+		std::fill(chunk.begin(), chunk.end(), 0);
+		std::copy(longer.begin() + offset, longer.begin() + offset + length, chunk.begin());
+
+		multiplyKaratsuba(chunk.data(), shorter.data(), n, product.data());
+		for (size_t i = 0; i < product.size() && offset + i < result.size(); i++)
+			result[offset + i] = Fp61::add(result[offset + i], product[i]);
+	}
+
+	trim(result);
+	return result;
+}
+
+
+/**
+ * Computes g with f*g = 1 (mod x^n) by Newton iteration, doubling the number
+ * of correct coefficients each step: g = g(2 - fg).
+ * 
+ * @param f A polynomial with a non-zero constant term.
+ * @param n The number of coefficients wanted.
+ * @param pool Threads for the products, or null.
+ * 
+ * @return The first n coefficients of 1/f.
+ */
+Polynomial::Coefficients Polynomial::inverseSeries(const Coefficients &f, size_t n, ThreadPool *pool) 
+{
+	if (f.empty() || f[0] == 0)
+		throw std::invalid_argument("Error: The power series has no inverse.");
+
+	Coefficients g = {Fp61::inv(f[0])};
+	for (size_t m = 1; m < n;) 
+	{
+		m = std::min(2*m, n);
+		Coefficients fLow(f.begin(), f.begin() + std::min(m, f.size()));
+
+		// e = 2 - f*g (mod x^m)
+		Coefficients e = multiply(fLow, g, pool);
+		e.resize(m, 0);
+		for (uint64_t &coefficient : e)
+			coefficient = Fp61::neg(coefficient);
+		e[0] = Fp61::add(e[0], 2);
+
+		g = multiply(g, e, pool);
+		g.resize(m, 0);
+	}
+
+	g.resize(n, 0);
+	return g;
+}
+
+
+/**
+ * Divides a by b using reversed polynomials: if a = qb + r then
+ * rev(a) = rev(q) rev(b) (mod x^{deg a - deg b + 1}), so q comes from one 
+ * power series inverse and one multiplication.
+ * 
+ * @param a The dividend.
+ * @param b The divisor, which must not be zero.
+ * @param quotient Set to q.
+ * @param remainder Set to r, with deg r < deg b.
+ * @param pool Threads for the products, or null.
+ */
+void Polynomial::divide(const Coefficients &a, const Coefficients &b, Coefficients &quotient, Coefficients &remainder, 
+	ThreadPool *pool) 
+{
+	Coefficients dividend(a), divisor(b);
+	trim(dividend);
+	trim(divisor);
+	if (divisor.empty())
+		throw std::invalid_argument("Error: Division by the zero polynomial.");
+
+	if (dividend.size() < divisor.size()) 
+	{
+		quotient.clear();
+		remainder = dividend;
+		return;
+	}
+
+	size_t quotientSize = dividend.size() - divisor.size() + 1;
+	Coefficients reversedA(dividend.rbegin(), dividend.rbegin() + quotientSize);
+	Coefficients reversedB(divisor.rbegin(), divisor.rend());
+
+	quotient = multiply(reversedA, inverseSeries(reversedB, quotientSize, pool), pool);
+	quotient.resize(quotientSize, 0);
+	std::reverse(quotient.begin(), quotient.end());
+	trim(quotient);
+
+	Coefficients product = multiply(quotient, divisor, pool);
+	remainder.assign(divisor.size() - 1, 0);
+	for (size_t i = 0; i < remainder.size(); i++)
+		remainder[i] = Fp61::sub(dividend[i], i < product.size() ? product[i] : 0);
+	trim(remainder);
+}
+
+
+Polynomial::Coefficients Polynomial::remainder(const Coefficients &a, const Coefficients &b, ThreadPool *pool) 
+{
+	Coefficients quotient, rest;
+	divide(a, b, quotient, rest, pool);
+	return rest;
+}
+
+
+Polynomial::Coefficients Polynomial::derivative(const Coefficients &f) 
+{
+	Coefficients result;
+	for (size_t i = 1; i < f.size(); i++)
+		result.push_back(Fp61::mul(f[i], i));
+
+	trim(result);
+	return result;
+}
+
+
+uint64_t Polynomial::evaluate(const Coefficients &f, uint64_t x) 
+{
+	uint64_t y = 0;
+	for (size_t j = f.size(); j-- > 0;)
+		y = Fp61::add(Fp61::mul(y, x), f[j]);
+
+	return y;
+}
+
+
+/**
+ * Builds the subproduct tree: level 0 holds x - x_{i}, and each node above is 
+ * the product of its two children (an odd node out is carried up as is).
+ * The root is (x - x_{1})...(x - x_{k}).
+ *  With a thread pool, levels with at least 3 products share them out 
+ *  between the threads, and the few large products near the root are each 
+ *  split across the threads instead.
+ */
+Polynomial::SubproductTree Polynomial::buildSubproductTree(const std::vector<uint64_t> &roots, ThreadPool *pool) 
+{
+	SubproductTree tree(1);
+	for (uint64_t root : roots)
+		tree[0].push_back({Fp61::neg(root), 1});
+
+	while (tree.back().size() > 1) 
+	{
+		const std::vector<Coefficients> &below = tree.back();
+		std::vector<Coefficients> above(below.size() / 2);
+		if (pool && above.size() >= 3) 
+		{
+			pool->parallelFor(above.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					above[i] = multiply(below[2*i], below[2*i+1]);
+			});
+		}
+		else 
+		{
+			for (size_t i = 0; i < above.size(); i++)
+				above[i] = multiply(below[2*i], below[2*i+1], pool);
+		}
+		if (below.size() % 2 == 1)
+			above.push_back(below.back());
+
+		tree.push_back(std::move(above));
+	}
+
+	return tree;
+}
+
+
+Polynomial::Coefficients Polynomial::fromRoots(const std::vector<uint64_t> &roots) 
+{
+	if (roots.empty())
+		return {1};
+
+	return buildSubproductTree(roots).back()[0];
+}
+
+
+/**
+ * Evaluates f at every point under one node of the subproduct tree. 
+ *  f mod node has the same values at the node's points, so remainders are 
+ *  taken on the way down. Small nodes evaluate their remainder directly.
+ */
+void Polynomial::evaluateDown(const SubproductTree &tree, size_t level, size_t index, 
+	const Coefficients &f, const std::vector<uint64_t> &xValues, std::vector<uint64_t> &values) 
+{
+	// The node covers the leaves [index << level, (index+1) << level)
+	size_t first = index << level;
+	size_t last = std::min(xValues.size(), (index+1) << level);
+
+	if (level == 0 || last - first <= karatsubaThreshold) 
+	{
+		for (size_t i = first; i < last; i++)
+			values[i] = evaluate(f, xValues[i]);
+		return;
+	}
+
+	for (size_t child = 2*index; child <= 2*index+1 && child < tree[level-1].size(); child++) 
+	{
+		Coefficients reduced = remainder(f, tree[level-1][child]);
+		evaluateDown(tree, level-1, child, reduced, xValues, values);
+	}
+}
+
+
+/**
+ * Evaluates f at many points with the subproduct tree, in 
+ * O(M(k) log k) operations where M(k) is the cost of multiplication.
+ * 
+ * @param f The polynomial.
+ * @param xValues The points.
+ * 
+ * @return f(x_{1}), ..., f(x_{k}).
+ */
+std::vector<uint64_t> Polynomial::evaluateMany(const Coefficients &f, const std::vector<uint64_t> &xValues) 
+{
+	std::vector<uint64_t> values(xValues.size());
+	if (xValues.empty())
+		return values;
+
+	SubproductTree tree = buildSubproductTree(xValues);
+	size_t top = tree.size()-1;
+	evaluateDown(tree, top, 0, remainder(f, tree[top][0]), xValues, values);
+
+	return values;
+}
+
+
+/**
+ * Evaluates the derivative of M = (x - x_{1})...(x - x_{k}) at every root,
+ * sharing one subproduct tree for building M and for the evaluation.
+ * 
+ * With a thread pool, the remainders near the root are taken breadth first, 
+ * with their products split across the threads, until there is a subtree for 
+ * every thread. The subtrees are then evaluated in parallel.
+ * 
+ * @param roots The roots x_{1}, ..., x_{k}.
+ * @param pool Threads to share the work between, or null.
+ * 
+ * @return M'(x_{1}), ..., M'(x_{k}).
+ */
+std::vector<uint64_t> Polynomial::derivativeAtRoots(const std::vector<uint64_t> &roots, ThreadPool *pool) 
+{
+	std::vector<uint64_t> values(roots.size());
+	if (roots.empty())
+		return values;
+
+	SubproductTree tree = buildSubproductTree(roots, pool);
+	size_t level = tree.size()-1;
+
+	// deg M' < deg M, so M' is already reduced modulo the root
+	std::vector<size_t> nodes = {0};
+	std::vector<Coefficients> reduced = {derivative(tree[level][0])};
+	if (!pool || pool->size() < 2) 
+	{
+		evaluateDown(tree, level, 0, reduced[0], roots, values);
+		return values;
+	}
+
+	while (level > 0 && nodes.size() < pool->size() && (size_t(1) << level) > parallelThreshold) 
+	{
+		std::vector<size_t> children;
+		std::vector<Coefficients> below;
+		for (size_t n = 0; n < nodes.size(); n++) 
+		{
+			for (size_t child = 2*nodes[n]; child <= 2*nodes[n]+1 && child < tree[level-1].size(); child++) 
+			{
+				children.push_back(child);
+				below.push_back(remainder(reduced[n], tree[level-1][child], pool));
+			}
+		}
+
+		nodes = std::move(children);
+		reduced = std::move(below);
+		level--;
+	}
+
+	// Each subtree writes its own range of values
+	pool->parallelFor(nodes.size(), [&](size_t begin, size_t end)
+	{
+		for (size_t n = begin; n < end; n++)
+			evaluateDown(tree, level, nodes[n], reduced[n], roots, values);
+	});
+
+	return values;
+}
+
+
+/**
+ * Interpolates the polynomial through k points with the subproduct tree.
+ *  f = sum c_{i} M/(x - x_{i}) where c_{i} = y_{i}/M'(x_{i}). The sums are 
+ *  built up the tree: a node's sum is left*M_{right} + right*M_{left}.
+ * 
+ * @param xValues The distinct x-values.
+ * @param yValues The values at each x-value.
+ * 
+ * @return The coefficients of f, which has degree < k.
+ */
+Polynomial::Coefficients Polynomial::interpolate(const std::vector<uint64_t> &xValues, const std::vector<uint64_t> &yValues) 
+{
+	if (xValues.size() != yValues.size())
+		throw std::invalid_argument("Error: Expected one y-value for every x-value.");
+	if (xValues.empty())
+		return {};
+
+	SubproductTree tree = buildSubproductTree(xValues);
+	size_t top = tree.size()-1;
+
+	std::vector<uint64_t> weights(xValues.size());
+	evaluateDown(tree, top, 0, derivative(tree[top][0]), xValues, weights);
+	Fp61::batchInv(weights);
+
+	std::vector<Coefficients> sums(xValues.size());
+	for (size_t i = 0; i < xValues.size(); i++) 
+	{
+		sums[i] = {Fp61::mul(yValues[i], weights[i])};
+		trim(sums[i]);
+	}
+
+	for (size_t level = 0; level < top; level++) 
+	{
+		const std::vector<Coefficients> &nodes = tree[level];
+		std::vector<Coefficients> above;
+		for (size_t i = 0; i+1 < nodes.size(); i += 2) 
+		{
+			Coefficients sum = multiply(sums[i], nodes[i+1]);
+			Coefficients right = multiply(sums[i+1], nodes[i]);
+			if (sum.size() < right.size())
+				sum.resize(right.size(), 0);
+			for (size_t j = 0; j < right.size(); j++)
+				sum[j] = Fp61::add(sum[j], right[j]);
+			trim(sum);
+			above.push_back(std::move(sum));
+		}
+		if (nodes.size() % 2 == 1)
+			above.push_back(std::move(sums.back()));
+
+		sums = std::move(above);
+	}
+
+	return sums[0];
+}
@@ -0,0 +1,489 @@
+#include "polynomial-evaluator.h"
+#include "fp61.h"
+#include "stats.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+// GCC 12's AVX-512 headers trip -Wmaybe-uninitialized on their own undefined 
+// pass-through operands at -O2
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#define SSS_EVALUATOR_X86 1
+#endif
+
+
+/**
+ * Each kernel evaluates the polynomial at a fixed-size group of x-values and
+ * returns how many it handled. Every x-value and coefficient must already be 
+ * in [0, p).
+ */
+using GroupKernel = size_t (*)(const uint64_t *coefficients, size_t numCoefficients, 
+	const uint64_t *xValues, uint64_t *yValues, size_t count);
+
+
+/**
+ * Horner's scheme on 4 x-values at a time as independent scalar chains.
+ */
+static size_t evaluateScalar(const uint64_t *coefficients, size_t numCoefficients, 
+	const uint64_t *xValues, uint64_t *yValues, size_t count) 
+{
+	constexpr size_t lanes = 4;
+	size_t done = 0;
+
+	for (; done + lanes <= count; done += lanes) 
+	{
+		const uint64_t *x = xValues + done;
+		uint64_t y[lanes];
+		for (size_t l = 0; l < lanes; l++)
+			y[l] = coefficients[numCoefficients-1];
+
+		for (size_t j = numCoefficients-1; j-- > 0;) 
+		{
+			for (size_t l = 0; l < lanes; l++)
+				y[l] = Fp61::add(Fp61::mul(y[l], x[l]), coefficients[j]);
+		}
+
+		std::copy(y, y + lanes, yValues + done);
+	}
+
+	for (; done < count; done++) 
+	{
+		uint64_t y = coefficients[numCoefficients-1];
+		for (size_t j = numCoefficients-1; j-- > 0;)
+			y = Fp61::add(Fp61::mul(y, xValues[done]), coefficients[j]);
+		yValues[done] = y;
+	}
+
+	return count;
+}
+
+
+/**
+ * Each kernel computes (x - r_{1})...(x - r_{n}) for a group of points x and 
+ * returns how many points it handled. A factor x - r_{j} that is 0 counts as 
+ * 1, so when the points are the roots themselves each product skips j=i.
+ */
+using DifferenceKernel = size_t (*)(const uint64_t *roots, size_t numRoots, 
+	const uint64_t *points, uint64_t *products, size_t count);
+
+
+/**
+ * 4 points at a time as independent scalar chains. The zero factor is 
+ * replaced without branching.
+ */
+static size_t differencesScalar(const uint64_t *roots, size_t numRoots, 
+	const uint64_t *points, uint64_t *products, size_t count) 
+{
+	constexpr size_t rows = 4;
+	for (size_t i = 0; i < count; i += rows) 
+	{
+		size_t group = std::min(rows, count-i);
+		uint64_t x[rows], product[rows];
+		for (size_t r = 0; r < rows; r++)
+		{
+			x[r] = points[i + std::min(r, group-1)];
+			product[r] = 1;
+		}
+
+		for (size_t j = 0; j < numRoots; j++) 
+		{
+			for (size_t r = 0; r < rows; r++)
+			{
+				uint64_t difference = Fp61::sub(x[r], roots[j]);
+				product[r] = Fp61::mul(product[r], difference + (difference == 0));
+			}
+		}
+
+		std::copy(product, product + group, products + i);
+	}
+
+	return count;
+}
+
+
+/**
+ * Multiplies the partial products left in the lanes together pairwise, then 
+ * folds in the roots after the last whole vector.
+ */
+static uint64_t finishDifferences(uint64_t *lanes, size_t numLanes, uint64_t x, 
+	const uint64_t *roots, size_t first, size_t numRoots) 
+{
+	for (size_t width = numLanes / 2; width > 0; width /= 2)
+		for (size_t l = 0; l < width; l++)
+			lanes[l] = Fp61::mul(lanes[l], lanes[l + width]);
+
+	uint64_t product = lanes[0];
+	for (size_t j = first; j < numRoots; j++)
+	{
+		uint64_t difference = Fp61::sub(x, roots[j]);
+		product = Fp61::mul(product, difference + (difference == 0));
+	}
+	return product;
+}
+
+
+#ifdef SSS_EVALUATOR_X86
+/**
+ * a*b (mod p) in each 64-bit lane from 32x32-bit multiplies.
+ *  With a = ah*2^32 + al and b = bh*2^32 + bl (ah, bh < 2^29):
+ *  a*b = ah*bh*2^64 + (ah*bl + al*bh)*2^32 + al*bl
+ *  2^64 = 2^3 (mod p), and writing mid = ah*bl + al*bh = mh*2^29 + ml gives
+ *  mid*2^32 = mh*2^61 + ml*2^32 = mh + ml*2^32 (mod p).
+ *  The five folded terms add up to less than 2^63, so one more fold and a 
+ *  conditional subtract finish the reduction.
+ */
+__attribute__((target("avx2")))
+static inline __m256i mulAVX2(__m256i a, __m256i b) 
+{
+	const __m256i p = _mm256_set1_epi64x(Fp61::p);
+	const __m256i low29 = _mm256_set1_epi64x((1LL << 29) - 1);
+
+	__m256i ah = _mm256_srli_epi64(a, 32), bh = _mm256_srli_epi64(b, 32);
+	__m256i ll = _mm256_mul_epu32(a, b);
+	__m256i mid = _mm256_add_epi64(_mm256_mul_epu32(a, bh), _mm256_mul_epu32(ah, b));
+	__m256i hh = _mm256_mul_epu32(ah, bh);
+
+	__m256i s = _mm256_add_epi64(_mm256_slli_epi64(hh, 3), _mm256_srli_epi64(mid, 29));
+	s = _mm256_add_epi64(s, _mm256_slli_epi64(_mm256_and_si256(mid, low29), 32));
+	s = _mm256_add_epi64(s, _mm256_and_si256(ll, p));
+	s = _mm256_add_epi64(s, _mm256_srli_epi64(ll, 61));
+
+	s = _mm256_add_epi64(_mm256_and_si256(s, p), _mm256_srli_epi64(s, 61));
+
+	// s < 2p, so keep s where s < p and s-p elsewhere
+	__m256i isSmall = _mm256_cmpgt_epi64(p, s);
+	return _mm256_blendv_epi8(_mm256_sub_epi64(s, p), s, isSmall);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i addAVX2(__m256i a, __m256i b) 
+{
+	const __m256i p = _mm256_set1_epi64x(Fp61::p);
+	__m256i s = _mm256_add_epi64(a, b);
+	__m256i isSmall = _mm256_cmpgt_epi64(p, s);
+	return _mm256_blendv_epi8(_mm256_sub_epi64(s, p), s, isSmall);
+}
+
+/**
+ * Horner's scheme on 8 x-values at a time, as two registers of 4 lanes.
+ */
+__attribute__((target("avx2")))
+static size_t evaluateAVX2(const uint64_t *coefficients, size_t numCoefficients, 
+	const uint64_t *xValues, uint64_t *yValues, size_t count) 
+{
+	size_t done = 0;
+	for (; done + 8 <= count; done += 8) 
+	{
+		__m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xValues + done));
+		__m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xValues + done + 4));
+		__m256i y0 = _mm256_set1_epi64x(coefficients[numCoefficients-1]);
+		__m256i y1 = y0;
+
+		for (size_t j = numCoefficients-1; j-- > 0;) 
+		{
+			__m256i c = _mm256_set1_epi64x(coefficients[j]);
+			y0 = addAVX2(mulAVX2(y0, x0), c);
+			y1 = addAVX2(mulAVX2(y1, x1), c);
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(yValues + done), y0);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(yValues + done + 4), y1);
+	}
+
+	return done;
+}
+
+
+/**
+ * (x - r_{j}) (mod p) in each lane, with 0 replaced by 1. The all-ones mask 
+ * from the comparison is -1, so subtracting it adds 1 to the zero lanes.
+ */
+__attribute__((target("avx2")))
+static inline __m256i differenceAVX2(__m256i x, __m256i r) 
+{
+	const __m256i p = _mm256_set1_epi64x(Fp61::p);
+	__m256i d = _mm256_sub_epi64(_mm256_add_epi64(x, p), r);
+	__m256i isSmall = _mm256_cmpgt_epi64(p, d);
+	d = _mm256_blendv_epi8(_mm256_sub_epi64(d, p), d, isSmall);
+	return _mm256_sub_epi64(d, _mm256_cmpeq_epi64(d, _mm256_setzero_si256()));
+}
+
+/**
+ * 4 points at a time, each with its own register of 4 partial products over 
+ * the roots, reduced with finishDifferences at the end.
+ */
+__attribute__((target("avx2")))
+static size_t differencesAVX2(const uint64_t *roots, size_t numRoots, 
+	const uint64_t *points, uint64_t *products, size_t count) 
+{
+	constexpr size_t rows = 4, lanes = 4;
+	size_t whole = numRoots - numRoots % lanes;
+	size_t done = 0;
+
+	for (; done + rows <= count; done += rows) 
+	{
+		__m256i x[rows], product[rows];
+		for (size_t r = 0; r < rows; r++)
+		{
+			x[r] = _mm256_set1_epi64x(points[done + r]);
+			product[r] = _mm256_set1_epi64x(1);
+		}
+
+		for (size_t j = 0; j < whole; j += lanes) 
+		{
+			__m256i root = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(roots + j));
+			for (size_t r = 0; r < rows; r++)
+				product[r] = mulAVX2(product[r], differenceAVX2(x[r], root));
+		}
+
+		for (size_t r = 0; r < rows; r++)
+		{
+			alignas(32) uint64_t partial[lanes];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(partial), product[r]);
+			products[done + r] = finishDifferences(partial, lanes, points[done + r], roots, whole, numRoots);
+		}
+	}
+
+	return done;
+}
+
+
+/**
+ * The same reduction as mulAVX2 with 8 lanes. AVX-512 has unsigned 64-bit 
+ * min, so the conditional subtract is min(s, s-p): when s < p, s-p wraps 
+ * around to a larger value.
+ */
+__attribute__((target("avx512f")))
+static inline __m512i mulAVX512(__m512i a, __m512i b) 
+{
+	const __m512i p = _mm512_set1_epi64(Fp61::p);
+	const __m512i low29 = _mm512_set1_epi64((1LL << 29) - 1);
+
+	__m512i ah = _mm512_srli_epi64(a, 32), bh = _mm512_srli_epi64(b, 32);
+	__m512i ll = _mm512_mul_epu32(a, b);
+	__m512i mid = _mm512_add_epi64(_mm512_mul_epu32(a, bh), _mm512_mul_epu32(ah, b));
+	__m512i hh = _mm512_mul_epu32(ah, bh);
+
+	__m512i s = _mm512_add_epi64(_mm512_slli_epi64(hh, 3), _mm512_srli_epi64(mid, 29));
+	s = _mm512_add_epi64(s, _mm512_slli_epi64(_mm512_and_si512(mid, low29), 32));
+	s = _mm512_add_epi64(s, _mm512_and_si512(ll, p));
+	s = _mm512_add_epi64(s, _mm512_srli_epi64(ll, 61));
+
+	s = _mm512_add_epi64(_mm512_and_si512(s, p), _mm512_srli_epi64(s, 61));
+	return _mm512_min_epu64(s, _mm512_sub_epi64(s, p));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i addAVX512(__m512i a, __m512i b) 
+{
+	const __m512i p = _mm512_set1_epi64(Fp61::p);
+	__m512i s = _mm512_add_epi64(a, b);
+	return _mm512_min_epu64(s, _mm512_sub_epi64(s, p));
+}
+
+/**
+ * Horner's scheme on 16 x-values at a time, as two registers of 8 lanes.
+ */
+__attribute__((target("avx512f")))
+static size_t evaluateAVX512(const uint64_t *coefficients, size_t numCoefficients, 
+	const uint64_t *xValues, uint64_t *yValues, size_t count) 
+{
+	size_t done = 0;
+	for (; done + 16 <= count; done += 16) 
+	{
+		__m512i x0 = _mm512_loadu_si512(xValues + done);
+		__m512i x1 = _mm512_loadu_si512(xValues + done + 8);
+		__m512i y0 = _mm512_set1_epi64(coefficients[numCoefficients-1]);
+		__m512i y1 = y0;
+
+		for (size_t j = numCoefficients-1; j-- > 0;) 
+		{
+			__m512i c = _mm512_set1_epi64(coefficients[j]);
+			y0 = addAVX512(mulAVX512(y0, x0), c);
+			y1 = addAVX512(mulAVX512(y1, x1), c);
+		}
+
+		_mm512_storeu_si512(yValues + done, y0);
+		_mm512_storeu_si512(yValues + done + 8, y1);
+	}
+
+	return done;
+}
+
+
+__attribute__((target("avx512f")))
+static inline __m512i differenceAVX512(__m512i x, __m512i r) 
+{
+	const __m512i p = _mm512_set1_epi64(Fp61::p);
+	__m512i d = _mm512_sub_epi64(_mm512_add_epi64(x, p), r);
+	d = _mm512_min_epu64(d, _mm512_sub_epi64(d, p));
+	__mmask8 isZero = _mm512_cmpeq_epi64_mask(d, _mm512_setzero_si512());
+	return _mm512_mask_mov_epi64(d, isZero, _mm512_set1_epi64(1));
+}
+
+/**
+ * 4 points at a time, each with its own register of 8 partial products.
+ */
+__attribute__((target("avx512f")))
+static size_t differencesAVX512(const uint64_t *roots, size_t numRoots, 
+	const uint64_t *points, uint64_t *products, size_t count) 
+{
+	constexpr size_t rows = 4, lanes = 8;
+	size_t whole = numRoots - numRoots % lanes;
+	size_t done = 0;
+
+	for (; done + rows <= count; done += rows) 
+	{
+		__m512i x[rows], product[rows];
+		for (size_t r = 0; r < rows; r++)
+		{
+			x[r] = _mm512_set1_epi64(points[done + r]);
+			product[r] = _mm512_set1_epi64(1);
+		}
+
+		for (size_t j = 0; j < whole; j += lanes) 
+		{
+			__m512i root = _mm512_loadu_si512(roots + j);
+			for (size_t r = 0; r < rows; r++)
+				product[r] = mulAVX512(product[r], differenceAVX512(x[r], root));
+		}
+
+		for (size_t r = 0; r < rows; r++)
+		{
+			alignas(64) uint64_t partial[lanes];
+			_mm512_store_si512(partial, product[r]);
+			products[done + r] = finishDifferences(partial, lanes, points[done + r], roots, whole, numRoots);
+		}
+	}
+
+	return done;
+}
+#endif
+
+
+static bool isSupported(PolynomialEvaluator::Kernel kernel) 
+{
+#ifdef SSS_EVALUATOR_X86
+	// Needed because this also runs during static initialisation
+	__builtin_cpu_init();
+	if (kernel == PolynomialEvaluator::Kernel::AVX512)
+		return __builtin_cpu_supports("avx512f");
+	if (kernel == PolynomialEvaluator::Kernel::AVX2)
+		return __builtin_cpu_supports("avx2");
+#endif
+	return kernel == PolynomialEvaluator::Kernel::Scalar;
+}
+
+static PolynomialEvaluator::Kernel bestKernel() 
+{
+	if (isSupported(PolynomialEvaluator::Kernel::AVX512))
+		return PolynomialEvaluator::Kernel::AVX512;
+	if (isSupported(PolynomialEvaluator::Kernel::AVX2))
+		return PolynomialEvaluator::Kernel::AVX2;
+	return PolynomialEvaluator::Kernel::Scalar;
+}
+
+static PolynomialEvaluator::Kernel activeKernel = bestKernel();
+
+static GroupKernel groupKernel() 
+{
+#ifdef SSS_EVALUATOR_X86
+	if (activeKernel == PolynomialEvaluator::Kernel::AVX512)
+		return evaluateAVX512;
+	if (activeKernel == PolynomialEvaluator::Kernel::AVX2)
+		return evaluateAVX2;
+#endif
+	return evaluateScalar;
+}
+
+static DifferenceKernel differenceKernel() 
+{
+#ifdef SSS_EVALUATOR_X86
+	if (activeKernel == PolynomialEvaluator::Kernel::AVX512)
+		return differencesAVX512;
+	if (activeKernel == PolynomialEvaluator::Kernel::AVX2)
+		return differencesAVX2;
+#endif
+	return differencesScalar;
+}
+
+
+PolynomialEvaluator::Kernel PolynomialEvaluator::getKernel() 
+{
+	return activeKernel;
+}
+
+
+/**
+ * Overrides the kernel chosen for this CPU, e.g. to compare against the scalar
+ * fallback. It isn't synchronised, so call it before evaluation starts.
+ * 
+ * @param kernel The kernel to use.
+ * 
+ * @return False if this CPU doesn't support the kernel, which leaves it unchanged.
+ */
+bool PolynomialEvaluator::setKernel(Kernel kernel) 
+{
+	if (!isSupported(kernel))
+		return false;
+
+	activeKernel = kernel;
+	return true;
+}
+
+
+/**
+ * Evaluates the polynomial at every x-value. The SIMD kernel takes whole 
+ * groups of x-values and the scalar kernel finishes the remainder.
+ * 
+ * @param coefficients The coefficients, constant term first, all in [0, p).
+ * @param numCoefficients The number of coefficients (the degree + 1).
+ * @param xValues The x-values, all in [0, p).
+ * @param yValues Where to write P(x) for each x-value.
+ * @param count The number of x-values.
+ */
+void PolynomialEvaluator::evaluate(const uint64_t *coefficients, size_t numCoefficients, 
+	const uint64_t *xValues, uint64_t *yValues, size_t count) 
+{
+	if (numCoefficients == 0)
+	{
+		std::fill(yValues, yValues + count, 0);
+		return;
+	}
+
+	auto kernel = groupKernel();
+	size_t done = kernel(coefficients, numCoefficients, xValues, yValues, count);
+	evaluateScalar(coefficients, numCoefficients, xValues + done, yValues + done, count - done);
+
+	// The scalar kernel counts its own multiplications through Fp61::mul
+	if (kernel != evaluateScalar)
+		SSS_STATS_COUNT(Multiplications, done * (numCoefficients - 1));
+}
+
+
+/**
+ * Multiplies the differences between each point and every root:
+ *  products[i] = (x_{i} - r_{1})...(x_{i} - r_{n}), where a factor that is 0 
+ *  counts as 1. With the roots as the points this is M'(x_{i}) for 
+ *  M = (x - r_{1})...(x - r_{n}), the Lagrange denominators. The SIMD kernels 
+ *  spread the roots over the lanes and multiply the lanes together at the end.
+ * 
+ * @param roots The roots, all in [0, p).
+ * @param numRoots The number of roots.
+ * @param points The points, all in [0, p).
+ * @param products Where to write the product for each point.
+ * @param count The number of points.
+ */
+void PolynomialEvaluator::productsOfDifferences(const uint64_t *roots, size_t numRoots, 
+	const uint64_t *points, uint64_t *products, size_t count) 
+{
+	auto kernel = differenceKernel();
+	size_t done = kernel(roots, numRoots, points, products, count);
+	differencesScalar(roots, numRoots, points + done, products + done, count - done);
+
+	if (kernel != differencesScalar)
+		SSS_STATS_COUNT(Multiplications, done * numRoots);
+}
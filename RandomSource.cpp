@@ -0,0 +1,444 @@
+#include "random-source.h"
+#include "fp61.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/random.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#define SSS_CHACHA_X86 1
+#endif
+
+
+/**
+ * Fills values with uniform field elements by rejection sampling.
+ *  Each word is masked to 61 bits, which is uniform on [0, 2^61), and only 
+ *  2^61 - 1 = p and values below min are rejected. With min = 0 or 1 that 
+ *  happens about once in 2^60 draws, so the masking pass runs as a plain 
+ *  vectorizable loop and the redraw loop almost never does anything.
+ * 
+ * @param values The output.
+ * @param count The number of values.
+ * @param min The smallest allowed value.
+ */
+void RandomSource::fillFieldElements(uint64_t *values, size_t count, uint64_t min) 
+{
+	fill(values, count);
+
+	size_t rejected = 0;
+	for (size_t i = 0; i < count; i++) 
+	{
+		values[i] &= Fp61::p;
+		rejected += (values[i] == Fp61::p) | (values[i] < min);
+	}
+
+	for (size_t i = 0; rejected > 0 && i < count; i++) 
+	{
+		if (values[i] != Fp61::p && values[i] >= min)
+			continue;
+
+		do 
+		{
+			values[i] = (*this)() & Fp61::p;
+		} while (values[i] == Fp61::p || values[i] < min);
+		rejected--;
+	}
+}
+
+
+RandomSource::result_type RandomSource::operator()() 
+{
+	uint64_t word;
+	fill(&word, 1);
+	return word;
+}
+
+
+/**
+ * Each kernel writes the keystream blocks for counters counter, counter+1, ...
+ * from the given state, and returns how many it wrote. Each 64-byte block is 
+ * 8 little-endian words.
+ */
+using BlockKernel = size_t (*)(const uint32_t *state, uint64_t *words, size_t numBlocks);
+
+
+static inline uint32_t rotl(uint32_t v, int c) 
+{
+	return (v << c) | (v >> (32 - c));
+}
+
+static inline void quarterRound(uint32_t *x, int a, int b, int c, int d) 
+{
+	x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+	x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+	x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+	x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+}
+
+
+/**
+ * One block at a time: 10 double rounds of column then diagonal quarter 
+ * rounds, and the input added back in.
+ */
+static size_t generateScalar(const uint32_t *state, uint64_t *words, size_t numBlocks) 
+{
+	uint64_t counter = state[12] | uint64_t(state[13]) << 32;
+	for (size_t block = 0; block < numBlocks; block++) 
+	{
+		uint32_t input[16], x[16];
+		std::memcpy(input, state, sizeof(input));
+		input[12] = static_cast<uint32_t>(counter + block);
+		input[13] = static_cast<uint32_t>((counter + block) >> 32);
+		std::memcpy(x, input, sizeof(x));
+
+		for (int round = 0; round < 10; round++) 
+		{
+			quarterRound(x, 0, 4, 8, 12);
+			quarterRound(x, 1, 5, 9, 13);
+			quarterRound(x, 2, 6, 10, 14);
+			quarterRound(x, 3, 7, 11, 15);
+			quarterRound(x, 0, 5, 10, 15);
+			quarterRound(x, 1, 6, 11, 12);
+			quarterRound(x, 2, 7, 8, 13);
+			quarterRound(x, 3, 4, 9, 14);
+		}
+
+		for (int w = 0; w < 8; w++)
+			words[8*block + w] = (x[2*w] + input[2*w]) | uint64_t(x[2*w+1] + input[2*w+1]) << 32;
+	}
+
+	return numBlocks;
+}
+
+
+#ifdef SSS_CHACHA_X86
+/**
+ * The vector kernels run one block per lane: vector w holds word w of every 
+ * lane's block, and lane l's counter is counter + l. The finished words are 
+ * transposed back into whole blocks through a small table.
+ */
+template <int C>
+__attribute__((target("avx2")))
+static inline __m256i rotlAVX2(__m256i v) 
+{
+	return _mm256_or_si256(_mm256_slli_epi32(v, C), _mm256_srli_epi32(v, 32 - C));
+}
+
+__attribute__((target("avx2")))
+static inline void quarterRoundAVX2(__m256i *x, int a, int b, int c, int d, __m256i rot16, __m256i rot8) 
+{
+	x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = _mm256_shuffle_epi8(_mm256_xor_si256(x[d], x[a]), rot16);
+	x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = rotlAVX2<12>(_mm256_xor_si256(x[b], x[c]));
+	x[a] = _mm256_add_epi32(x[a], x[b]); x[d] = _mm256_shuffle_epi8(_mm256_xor_si256(x[d], x[a]), rot8);
+	x[c] = _mm256_add_epi32(x[c], x[d]); x[b] = rotlAVX2<7>(_mm256_xor_si256(x[b], x[c]));
+}
+
+/**
+ * 8 blocks at a time. Rotations by 16 and 8 are byte shuffles.
+ */
+__attribute__((target("avx2")))
+static size_t generateAVX2(const uint32_t *state, uint64_t *words, size_t numBlocks) 
+{
+	constexpr size_t lanes = 8;
+	const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 
+		2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	const __m256i rot8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 
+		3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+	uint64_t counter = state[12] | uint64_t(state[13]) << 32;
+	size_t done = 0;
+
+	for (; done + lanes <= numBlocks; done += lanes) 
+	{
+		alignas(32) uint32_t low[lanes], high[lanes];
+		for (size_t l = 0; l < lanes; l++) 
+		{
+			low[l] = static_cast<uint32_t>(counter + done + l);
+			high[l] = static_cast<uint32_t>((counter + done + l) >> 32);
+		}
+
+		__m256i input[16], x[16];
+		for (int w = 0; w < 16; w++)
+			input[w] = _mm256_set1_epi32(static_cast<int>(state[w]));
+		input[12] = _mm256_load_si256(reinterpret_cast<const __m256i*>(low));
+		input[13] = _mm256_load_si256(reinterpret_cast<const __m256i*>(high));
+		for (int w = 0; w < 16; w++)
+			x[w] = input[w];
+
+		for (int round = 0; round < 10; round++) 
+		{
+			quarterRoundAVX2(x, 0, 4, 8, 12, rot16, rot8);
+			quarterRoundAVX2(x, 1, 5, 9, 13, rot16, rot8);
+			quarterRoundAVX2(x, 2, 6, 10, 14, rot16, rot8);
+			quarterRoundAVX2(x, 3, 7, 11, 15, rot16, rot8);
+			quarterRoundAVX2(x, 0, 5, 10, 15, rot16, rot8);
+			quarterRoundAVX2(x, 1, 6, 11, 12, rot16, rot8);
+			quarterRoundAVX2(x, 2, 7, 8, 13, rot16, rot8);
+			quarterRoundAVX2(x, 3, 4, 9, 14, rot16, rot8);
+		}
+
+		alignas(32) uint32_t table[16][lanes];
+		for (int w = 0; w < 16; w++)
+			_mm256_store_si256(reinterpret_cast<__m256i*>(table[w]), _mm256_add_epi32(x[w], input[w]));
+		for (size_t l = 0; l < lanes; l++)
+			for (int w = 0; w < 8; w++)
+				words[8*(done + l) + w] = table[2*w][l] | uint64_t(table[2*w+1][l]) << 32;
+	}
+
+	return done;
+}
+
+
+template <int C>
+__attribute__((target("avx512f")))
+static inline __m512i rotlAVX512(__m512i v) 
+{
+	return _mm512_rol_epi32(v, C);
+}
+
+__attribute__((target("avx512f")))
+static inline void quarterRoundAVX512(__m512i *x, int a, int b, int c, int d) 
+{
+	x[a] = _mm512_add_epi32(x[a], x[b]); x[d] = rotlAVX512<16>(_mm512_xor_si512(x[d], x[a]));
+	x[c] = _mm512_add_epi32(x[c], x[d]); x[b] = rotlAVX512<12>(_mm512_xor_si512(x[b], x[c]));
+	x[a] = _mm512_add_epi32(x[a], x[b]); x[d] = rotlAVX512<8>(_mm512_xor_si512(x[d], x[a]));
+	x[c] = _mm512_add_epi32(x[c], x[d]); x[b] = rotlAVX512<7>(_mm512_xor_si512(x[b], x[c]));
+}
+
+/**
+ * 16 blocks at a time. AVX-512 has a native rotate.
+ */
+__attribute__((target("avx512f")))
+static size_t generateAVX512(const uint32_t *state, uint64_t *words, size_t numBlocks) 
+{
+	constexpr size_t lanes = 16;
+	uint64_t counter = state[12] | uint64_t(state[13]) << 32;
+	size_t done = 0;
+
+	for (; done + lanes <= numBlocks; done += lanes) 
+	{
+		alignas(64) uint32_t low[lanes], high[lanes];
+		for (size_t l = 0; l < lanes; l++) 
+		{
+			low[l] = static_cast<uint32_t>(counter + done + l);
+			high[l] = static_cast<uint32_t>((counter + done + l) >> 32);
+		}
+
+		__m512i input[16], x[16];
+		for (int w = 0; w < 16; w++)
+			input[w] = _mm512_set1_epi32(static_cast<int>(state[w]));
+		input[12] = _mm512_load_si512(low);
+		input[13] = _mm512_load_si512(high);
+		for (int w = 0; w < 16; w++)
+			x[w] = input[w];
+
+		for (int round = 0; round < 10; round++) 
+		{
+			quarterRoundAVX512(x, 0, 4, 8, 12);
+			quarterRoundAVX512(x, 1, 5, 9, 13);
+			quarterRoundAVX512(x, 2, 6, 10, 14);
+			quarterRoundAVX512(x, 3, 7, 11, 15);
+			quarterRoundAVX512(x, 0, 5, 10, 15);
+			quarterRoundAVX512(x, 1, 6, 11, 12);
+			quarterRoundAVX512(x, 2, 7, 8, 13);
+			quarterRoundAVX512(x, 3, 4, 9, 14);
+		}
+
+		alignas(64) uint32_t table[16][lanes];
+		for (int w = 0; w < 16; w++)
+			_mm512_store_si512(table[w], _mm512_add_epi32(x[w], input[w]));
+		for (size_t l = 0; l < lanes; l++)
+			for (int w = 0; w < 8; w++)
+				words[8*(done + l) + w] = table[2*w][l] | uint64_t(table[2*w+1][l]) << 32;
+	}
+
+	return done;
+}
+#endif
+
+
+static bool isSupported(ChaCha20Rng::Kernel kernel) 
+{
+#ifdef SSS_CHACHA_X86
+	// Needed because this also runs during static initialisation
+	__builtin_cpu_init();
+	if (kernel == ChaCha20Rng::Kernel::AVX512)
+		return __builtin_cpu_supports("avx512f");
+	if (kernel == ChaCha20Rng::Kernel::AVX2)
+		return __builtin_cpu_supports("avx2");
+#endif
+	return kernel == ChaCha20Rng::Kernel::Scalar;
+}
+
+static ChaCha20Rng::Kernel bestKernel() 
+{
+	if (isSupported(ChaCha20Rng::Kernel::AVX512))
+		return ChaCha20Rng::Kernel::AVX512;
+	if (isSupported(ChaCha20Rng::Kernel::AVX2))
+		return ChaCha20Rng::Kernel::AVX2;
+	return ChaCha20Rng::Kernel::Scalar;
+}
+
+static ChaCha20Rng::Kernel activeKernel = bestKernel();
+
+static BlockKernel blockKernel() 
+{
+#ifdef SSS_CHACHA_X86
+	if (activeKernel == ChaCha20Rng::Kernel::AVX512)
+		return generateAVX512;
+	if (activeKernel == ChaCha20Rng::Kernel::AVX2)
+		return generateAVX2;
+#endif
+	return generateScalar;
+}
+
+
+ChaCha20Rng::Kernel ChaCha20Rng::getKernel() 
+{
+	return activeKernel;
+}
+
+
+/**
+ * Overrides the kernel chosen for this CPU. Every kernel gives the same 
+ * keystream. It isn't synchronised, so call it before generating.
+ * 
+ * @param kernel The kernel to use.
+ * 
+ * @return False if this CPU doesn't support the kernel, which leaves it unchanged.
+ */
+bool ChaCha20Rng::setKernel(Kernel kernel) 
+{
+	if (!isSupported(kernel))
+		return false;
+
+	activeKernel = kernel;
+	return true;
+}
+
+
+/**
+ * The constructor.
+ *  Keys the generator with 256 bits from the kernel's CSPRNG. getrandom 
+ *  blocks until the kernel's pool is initialised, and then never fails for 
+ *  32 bytes except by being interrupted.
+ */
+ChaCha20Rng::ChaCha20Rng() 
+{
+	std::array<uint32_t, 8> key;
+	unsigned char *bytes = reinterpret_cast<unsigned char*>(key.data());
+	size_t filled = 0;
+	while (filled < sizeof(key)) 
+	{
+		ssize_t result = ::getrandom(bytes + filled, sizeof(key) - filled, 0);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result < 0)
+			throw std::runtime_error(std::string("Error: Couldn't seed the random number generator: ") + std::strerror(errno));
+		filled += static_cast<size_t>(result);
+	}
+
+	setKey(key, 0, 0);
+	explicit_bzero(key.data(), sizeof(key));
+}
+
+
+/**
+ * Keys the generator explicitly, for reproducible output such as test vectors.
+ * 
+ * @param key The 256-bit key as 8 little-endian words.
+ * @param nonce The nonce, words 14 and 15 of the state.
+ * @param counter The first block's counter, words 12 and 13 of the state.
+ */
+ChaCha20Rng::ChaCha20Rng(const std::array<uint32_t, 8> &key, uint64_t nonce, uint64_t counter) 
+{
+	setKey(key, nonce, counter);
+}
+
+
+ChaCha20Rng::~ChaCha20Rng() 
+{
+	explicit_bzero(this->state.data(), sizeof(this->state));
+	explicit_bzero(this->buffer.data(), sizeof(this->buffer));
+}
+
+
+void ChaCha20Rng::setKey(const std::array<uint32_t, 8> &key, uint64_t nonce, uint64_t counter) 
+{
+	// "expand 32-byte k"
+	this->state = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+	std::copy(key.begin(), key.end(), this->state.begin() + 4);
+	this->state[12] = static_cast<uint32_t>(counter);
+	this->state[13] = static_cast<uint32_t>(counter >> 32);
+	this->state[14] = static_cast<uint32_t>(nonce);
+	this->state[15] = static_cast<uint32_t>(nonce >> 32);
+}
+
+
+/**
+ * Writes numBlocks blocks of keystream and advances the counter past them.
+ *  The vector kernel takes whole groups of blocks and the scalar kernel 
+ *  finishes the remainder.
+ */
+void ChaCha20Rng::generate(uint64_t *words, size_t numBlocks) 
+{
+	size_t done = blockKernel()(this->state.data(), words, numBlocks);
+
+	uint64_t counter = (this->state[12] | uint64_t(this->state[13]) << 32) + done;
+	this->state[12] = static_cast<uint32_t>(counter);
+	this->state[13] = static_cast<uint32_t>(counter >> 32);
+
+	if (done < numBlocks)
+	{
+		generateScalar(this->state.data(), words + 8*done, numBlocks - done);
+		counter += numBlocks - done;
+		this->state[12] = static_cast<uint32_t>(counter);
+		this->state[13] = static_cast<uint32_t>(counter >> 32);
+	}
+}
+
+
+/**
+ * Fills words with keystream, continuing from the last call. Whole blocks 
+ * for large requests are generated straight into the output, and only the 
+ * ends go through the buffer.
+ * 
+ * @param words The output.
+ * @param count The number of words.
+ */
+void ChaCha20Rng::fill(uint64_t *words, size_t count) 
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	while (count > 0) 
+	{
+		if (this->bufferUsed == this->buffer.size()) 
+		{
+			if (count >= this->buffer.size()) 
+			{
+				size_t numBlocks = count / 8;
+				generate(words, numBlocks);
+				words += 8 * numBlocks;
+				count -= 8 * numBlocks;
+				continue;
+			}
+
+			generate(this->buffer.data(), bufferBlocks);
+			this->bufferUsed = 0;
+		}
+
+		size_t take = std::min(count, this->buffer.size() - this->bufferUsed);
+		std::copy(this->buffer.begin() + this->bufferUsed, this->buffer.begin() + this->bufferUsed + take, words);
+		explicit_bzero(this->buffer.data() + this->bufferUsed, take * sizeof(uint64_t));
+		this->bufferUsed += take;
+		words += take;
+		count -= take;
+	}
+}
@@ -0,0 +1,170 @@
+#include "recovery-plan.h"
+#include "fp61.h"
+#include "lagrange.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+/**
+ * Precomputes the Lagrange weights at x=0 for a set of x-values.
+ * 
+ * @param xValues The x-values of the holders. Must be in [1, p-1] and unique.
+ * @param pool Threads to compute the weights with, or null.
+ */
+RecoveryPlan::RecoveryPlan(const std::vector<uint64_t> &xValues, ThreadPool *pool) 
+: xValues(xValues) 
+{
+	for (uint64_t x : xValues) 
+	{
+		if (x < 1 || x > Fp61::p-1)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+	}
+
+	this->weights = Lagrange::weightsAtZero(xValues, pool);
+}
+
+
+size_t RecoveryPlan::size() const 
+{
+	return this->xValues.size();
+}
+
+const std::vector<uint64_t>& RecoveryPlan::getXValues() const 
+{
+	return this->xValues;
+}
+
+const std::vector<uint64_t>& RecoveryPlan::getWeights() const 
+{
+	return this->weights;
+}
+
+
+/**
+ * Recovers the secret as the dot product of the weights and y-values.
+ *  With a thread pool and enough shares, each thread sums a block of the 
+ *  products and the partial sums are added in block order.
+ * 
+ * @param yValues The y-values, in the same order as the plan's x-values. Each 
+ *        must be in [0, p-1], since the accumulator's 128-bit sum relies on it.
+ * @param pool Threads to share the dot product between, or null.
+ * 
+ * @return The secret, P(0).
+ */
+uint64_t RecoveryPlan::recover(const std::vector<uint64_t> &yValues, ThreadPool *pool) const 
+{
+	if (yValues.size() != this->weights.size())
+		throw std::invalid_argument("Error: The number of y-values doesn't match the recovery plan.");
+
+	return recover(yValues.data(), pool);
+}
+
+uint64_t RecoveryPlan::recover(const uint64_t *yValues, ThreadPool *pool) const 
+{
+	size_t k = this->weights.size();
+	for (size_t i = 0; i < k; i++) 
+	{
+		if (yValues[i] > Fp61::p-1)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+	}
+
+	auto dotProduct = [&](size_t begin, size_t end)
+	{
+		Fp61::Accumulator sum;
+		for (size_t i = begin; i < end; i++)
+			sum.addProduct(this->weights[i], yValues[i]);
+		return sum.value();
+	};
+
+	if (!pool || pool->size() < 2 || k < parallelThreshold)
+		return dotProduct(0, k);
+
+	size_t numBlocks = pool->size(), blockSize = (k + numBlocks - 1) / numBlocks;
+	std::vector<uint64_t> partials(numBlocks, 0);
+	pool->parallelFor(numBlocks, [&](size_t begin, size_t end)
+	{
+		for (size_t b = begin; b < end; b++)
+			partials[b] = dotProduct(std::min(k, b * blockSize), std::min(k, (b+1) * blockSize));
+	});
+
+	uint64_t secret = 0;
+	for (uint64_t partial : partials)
+		secret = Fp61::add(secret, partial);
+	return secret;
+}
+
+
+RecoveryPlanCache::RecoveryPlanCache(size_t capacity, size_t maxShares) 
+: capacity(capacity), maxShares(maxShares) 
+{
+}
+
+
+/**
+ * Returns the plan for a set of x-values, building it on a miss.
+ *  The plan is built outside of the lock so a slow, large-k build doesn't 
+ *  block lookups from other threads.
+ * 
+ * @param sortedXValues The x-values in ascending order.
+ * @param pool Threads to build a missing plan with, or null.
+ * 
+ * @return The shared recovery plan.
+ */
+std::shared_ptr<const RecoveryPlan> RecoveryPlanCache::get(const std::vector<uint64_t> &sortedXValues, ThreadPool *pool) 
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		auto found = this->index.find(&sortedXValues);
+		if (found != this->index.end())
+		{
+			// Move the entry to the front as the most recently used
+			this->entries.splice(this->entries.begin(), this->entries, found->second);
+			return *found->second;
+		}
+	}
+
+	auto plan = std::make_shared<const RecoveryPlan>(sortedXValues, pool);
+	if (this->capacity == 0 || plan->size() > this->maxShares)
+		return plan;
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (this->index.find(&sortedXValues) != this->index.end())
+		return plan;
+
+	this->entries.push_front(plan);
+	this->index.emplace(&plan->getXValues(), this->entries.begin());
+	this->numShares += plan->size();
+
+	// Evict the least recently used plans until both limits hold
+	while (this->entries.size() > this->capacity || this->numShares > this->maxShares)
+	{
+		this->numShares -= this->entries.back()->size();
+		this->index.erase(&this->entries.back()->getXValues());
+		this->entries.pop_back();
+	}
+
+	return plan;
+}
+
+
+size_t RecoveryPlanCache::size() const 
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->entries.size();
+}
+
+void RecoveryPlanCache::clear() 
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->index.clear();
+	this->entries.clear();
+	this->numShares = 0;
+}
+
+
+RecoveryPlanCache& RecoveryPlanCache::global() 
+{
+	static RecoveryPlanCache cache(16);
+	return cache;
+}
@@ -0,0 +1,72 @@
+#include "reed-solomon.h"
+#include "fp61.h"
+
+#include <algorithm>
+#include <utility>
+
+
+/**
+ * Gao's decoding algorithm.
+ *  1. G0 = (x - x_{1})...(x - x_{n}), and G1 interpolates all n points.
+ *  2. Run the extended Euclidean algorithm on G0 and G1, tracking only the 
+ *     multiplier of G1, until the remainder g has degree < (n+k)/2. Then 
+ *     g = u*G0 + v*G1.
+ *  3. If f = g/v divides exactly and has degree < k, f is the message. The 
+ *     positions where f disagrees with the received values are the errors.
+ * 
+ * @param xValues The distinct evaluation points.
+ * @param yValues The received values, some of which may be wrong.
+ * @param k The message length, i.e. the polynomial has degree < k.
+ * @param message Set to the decoded polynomial.
+ * @param errorPositions Set to the indices of the wrong values.
+ * 
+ * @return False if there are more errors than can be corrected.
+ */
+bool ReedSolomon::decode(const std::vector<uint64_t> &xValues, const std::vector<uint64_t> &yValues, 
+	size_t k, Polynomial::Coefficients &message, std::vector<size_t> &errorPositions) 
+{
+	size_t n = xValues.size();
+	Polynomial::Coefficients g0 = Polynomial::fromRoots(xValues);
+	Polynomial::Coefficients g1 = Polynomial::interpolate(xValues, yValues);
+
+	// Remainders r and the multipliers v of G1, starting from (G0, 0), (G1, 1)
+	Polynomial::Coefficients previousR = g0, r = g1;
+	Polynomial::Coefficients previousV = {}, v = {1};
+
+	size_t stopDegree = (n + k + 1) / 2;
+	while (!r.empty() && r.size()-1 >= stopDegree) 
+	{
+		Polynomial::Coefficients quotient, nextR;
+		Polynomial::divide(previousR, r, quotient, nextR);
+
+		// v_{next} = v_{previous} - quotient*v
+		Polynomial::Coefficients product = Polynomial::multiply(quotient, v);
+		Polynomial::Coefficients nextV(std::max(previousV.size(), product.size()), 0);
+		for (size_t i = 0; i < nextV.size(); i++)
+			nextV[i] = Fp61::sub(i < previousV.size() ? previousV[i] : 0, i < product.size() ? product[i] : 0);
+		while (!nextV.empty() && nextV.back() == 0)
+			nextV.pop_back();
+
+		previousR = std::move(r);
+		r = std::move(nextR);
+		previousV = std::move(v);
+		v = std::move(nextV);
+	}
+
+	Polynomial::Coefficients quotient, rest;
+	Polynomial::divide(r, v, quotient, rest);
+	if (!rest.empty() || quotient.size() > k)
+		return false;
+
+	errorPositions.clear();
+	for (size_t i = 0; i < n; i++) 
+	{
+		if (Polynomial::evaluate(quotient, xValues[i]) != yValues[i])
+			errorPositions.push_back(i);
+	}
+	if (2*errorPositions.size() > n-k)
+		return false;
+
+	message = std::move(quotient);
+	return true;
+}
@@ -1,5 +1,11 @@
 #include "shamir.h"
+#include "lagrange.h"
+#include "polynomial-evaluator.h"
+#include "recovery-plan.h"
+#include "reed-solomon.h"
+#include "stats.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 
@@ -7,15 +13,19 @@
  * The constructor.
  *  Given a secret and threshold, it immediately generates the degree k-1 
  *  polynomial: P(x) = secret + a_{1}x^{1} + ... + a_{k-1}x^{k-1}
+ *  The coefficients come from randomSource, or a new ChaCha20Rng if it's null.
  */
-ShamirsSecretSharing::ShamirsSecretSharing(uint64_t secret, uint64_t threshold) 
-: secret(secret), threshold(threshold), rng(std::random_device{}()) 
+ShamirsSecretSharing::ShamirsSecretSharing(uint64_t secret, uint64_t threshold, std::shared_ptr<RandomSource> randomSource) 
+: secret(secret), threshold(threshold), randomSource(std::move(randomSource)) 
 {
 	if (secret > p-1)
 		throw std::domain_error("Error: The secret is too large.");
 	if (threshold < 2 || threshold > p-1)
 		throw std::domain_error("Error: The threshold (k) is outside the range.");
 
+	if (!this->randomSource)
+		this->randomSource = std::make_shared<ChaCha20Rng>();
+
 	// Immediately hide the secret in the degree k-1 polynomial.
 	this->coefficients = generateCoefficients();
 }
@@ -31,16 +41,73 @@ uint64_t ShamirsSecretSharing::getThreshold() const
 	return this->threshold;
 }
 
-const std::vector<Share>& ShamirsSecretSharing::getShares() const 
+const CompactShares& ShamirsSecretSharing::getShares() const 
 {
 	return this->shares;
 }
 
+unsigned ShamirsSecretSharing::getNumThreads() const 
+{
+	return this->threadPool ? this->threadPool->size() : 1;
+}
+
+
+/**
+ * Sets the number of threads used to generate shares. 1 means the calling 
+ * thread does all of the work.
+ * 
+ * @param numThreads The number of threads, at least 1.
+ */
+void ShamirsSecretSharing::setNumThreads(unsigned numThreads) 
+{
+	if (numThreads < 1)
+		throw std::domain_error("Error: The number of threads must be at least 1.");
+
+	if (numThreads == 1)
+		this->threadPool.reset();
+	else if (numThreads != getNumThreads())
+		this->threadPool = std::make_shared<ThreadPool>(numThreads);
+}
+
+
+std::shared_ptr<ThreadPool> ShamirsSecretSharing::recoveryThreadPool;
+std::mutex ShamirsSecretSharing::recoveryThreadMutex;
+
+unsigned ShamirsSecretSharing::getRecoveryThreads() 
+{
+	std::lock_guard<std::mutex> lock(recoveryThreadMutex);
+	return recoveryThreadPool ? recoveryThreadPool->size() : 1;
+}
+
+
+/**
+ * Sets the number of threads recoverSecret uses for large k. The Lagrange 
+ * denominators, or the subproduct tree from k = 2^14, and the final dot 
+ * product are split between them. The secret is the same for any number of 
+ * threads. Recoveries already running keep the threads they started with.
+ * 
+ * @param numThreads The number of threads, at least 1.
+ */
+void ShamirsSecretSharing::setRecoveryThreads(unsigned numThreads) 
+{
+	if (numThreads < 1)
+		throw std::domain_error("Error: The number of threads must be at least 1.");
+
+	std::lock_guard<std::mutex> lock(recoveryThreadMutex);
+	if (numThreads == 1)
+		recoveryThreadPool.reset();
+	else if (!recoveryThreadPool || recoveryThreadPool->size() != numThreads)
+		recoveryThreadPool = std::make_shared<ThreadPool>(numThreads);
+}
+
 
 /**
  * Generates n additional shares by selecting points which lie on the polynomial.
  *  x-values are [1, 2, ..., n]
- * New shares are added to the existing list of shares.
+ * New shares are added to the existing list of shares. With more than one 
+ * thread the x-range is split between them, giving the same shares. The 
+ * difference table is kept between calls, so extending the shares continues
+ * from where the last call left off.
  * 
  * @param numToGenerate The number of new shares to create.
  * 
@@ -48,16 +115,267 @@ const std::vector<Share>& ShamirsSecretSharing::getShares() const
  */
 void ShamirsSecretSharing::generateAdditionalShares(uint64_t numToGenerate) 
 {
+	SSS_STATS_TIMER(GenerateAdditionalShares);
+
 	size_t prevSize = this->shares.size();
 	if (numToGenerate > p-1-prevSize)
 		throw std::domain_error("Error: The number of shares requested is outside the range.");
+	SSS_STATS_COUNT(SharesGenerated, numToGenerate);
+
+	this->shares.resize(prevSize + numToGenerate);
+	uint64_t *newShares = this->shares.data() + prevSize;
+	if (!this->threadPool)
+	{
+		fillShares(prevSize + 1, numToGenerate, newShares, this->differenceTable);
+		return;
+	}
+
+	// Each thread fills a contiguous range of x-values, writing straight into 
+	// its own slice of the shares with its own difference table
+	this->threadPool->parallelFor(numToGenerate, [&](size_t begin, size_t end) 
+	{
+		DifferenceTable table;
+		fillShares(prevSize + 1 + begin, end - begin, newShares + begin, table);
+	});
+}
+
+
+/**
+ * Issues shares at arbitrary x-values without adding them to the list of 
+ * shares. The caller is responsible for not reusing x-values between holders.
+ * 
+ * @param xValues The x-values, in [1, p-1].
+ * 
+ * @return The shares.
+ */
+std::vector<Share> ShamirsSecretSharing::getSharesAt(const std::vector<uint64_t> &xValues) const 
+{
+	for (uint64_t x : xValues) 
+	{
+		if (x < 1 || x > p-1)
+			throw std::domain_error("Error: A requested x-value is outside the field range.");
+	}
+
+	std::vector<uint64_t> yValues(xValues.size());
+	evaluatePolynomial(xValues.data(), yValues.data(), xValues.size());
+
+	std::vector<Share> shares(xValues.size());
+	for (size_t i = 0; i < xValues.size(); i++)
+		shares[i] = {xValues[i], yValues[i]};
+
+	return shares;
+}
+
+
+/**
+ * Gives a lazy view of the shares at consecutive x-values, which computes 
+ * each share when it is read. Nothing is added to the list of shares, so a 
+ * dealer can issue any number of shares in O(k) memory.
+ * 
+ * @param firstX The first x-value, in [1, p-1].
+ * @param count The number of shares.
+ * 
+ * @return The shares at x = firstX, ..., firstX+count-1.
+ */
+ShareRange ShamirsSecretSharing::getShareRange(uint64_t firstX, uint64_t count) const 
+{
+	return ShareRange(this->coefficients, firstX, count);
+}
+
+
+/**
+ * Evaluates the polynomial at consecutive x-values.
+ *  If the table already continues from firstX, or there are enough points to 
+ *  pay for setting one up, the values come from forward differences: d 
+ *  additions per point instead of d multiplications. Otherwise each point is 
+ *  evaluated directly.
+ * 
+ * @param firstX The first x-value.
+ * @param count The number of consecutive x-values.
+ * @param yValues Where to write the y-values.
+ * @param table The difference table to continue from, or to replace.
+ */
+void ShamirsSecretSharing::fillShares(uint64_t firstX, size_t count, uint64_t *yValues, DifferenceTable &table) const 
+{
+	if (table.isEmpty() || table.getNextX() != firstX) 
+	{
+		if (count < 2*threshold) 
+		{
+			std::vector<uint64_t> xValues(count);
+			for (size_t i = 0; i < count; i++)
+				xValues[i] = firstX + i;
+			evaluatePolynomial(xValues.data(), yValues, count);
+			return;
+		}
+		table = makeDifferenceTable(firstX);
+	}
+
+	for (size_t i = 0; i < count; i++)
+		yValues[i] = table.next();
+}
+
+
+/**
+ * Sets up a forward difference table from P(firstX), ..., P(firstX+k-1).
+ * 
+ * @param firstX The x-value to start from.
+ * 
+ * @return The table, ready to produce P(firstX).
+ */
+DifferenceTable ShamirsSecretSharing::makeDifferenceTable(uint64_t firstX) const 
+{
+	std::vector<uint64_t> xValues(threshold), values(threshold);
+	for (size_t i = 0; i < threshold; i++)
+		xValues[i] = mod(firstX + i);
+	evaluatePolynomial(xValues.data(), values.data(), threshold);
+
+	return DifferenceTable(firstX, values);
+}
+
+
+/**
+ * Recovers the secret from shares at consecutive x-values without expanding 
+ * them into pairs. The weights come from the closed form for evenly spaced 
+ * x-values, and are applied straight to the stored y-values.
+ * 
+ * @param userShares The shares.
+ * 
+ * @return The secret based on the Lagrange Interpolation Formula at P(0).
+ */
+uint64_t ShamirsSecretSharing::recoverSecret(const CompactShares &userShares) 
+{
+	if (userShares.getLayout() == CompactShares::Layout::Words)
+		return recoverSecret(userShares.getFirstX(), userShares.data(), userShares.size());
+
+	SSS_STATS_TIMER(RecoverSecret);
+	std::vector<uint64_t> weights = Lagrange::weightsAtZeroArithmetic(userShares.getFirstX(), 1, userShares.size());
+
+	Fp61::Accumulator secret;
+	for (size_t i = 0; i < weights.size(); i++)
+		secret.addProduct(weights[i], userShares.getY(i));
+
+	return secret.value();
+}
+
+
+/**
+ * Recovers the secret from y-values at x = firstX, ..., firstX+count-1 held 
+ * anywhere in memory, such as a mapped share file.
+ * 
+ * @param firstX The x-value of the first y-value.
+ * @param yValues The y-values.
+ * @param count The number of y-values.
+ * 
+ * @return The secret based on the Lagrange Interpolation Formula at P(0).
+ */
+uint64_t ShamirsSecretSharing::recoverSecret(uint64_t firstX, const uint64_t *yValues, size_t count) 
+{
+	SSS_STATS_TIMER(RecoverSecret);
+
+	if (firstX < 1 || firstX > p-1 || count > p - firstX)
+		throw std::domain_error("Error: A provided share is outside the field range.");
+
+	std::vector<uint64_t> weights = Lagrange::weightsAtZeroArithmetic(firstX, 1, count);
+
+	Fp61::Accumulator secret;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (yValues[i] > p-1)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+		secret.addProduct(weights[i], yValues[i]);
+	}
+
+	return secret.value();
+}
+
+
+/**
+ * Refreshes shares in place without reconstructing the secret.
+ *  A random polynomial D with D(0) = 0 and degree at most k-1 is added to the 
+ *  shares. The new shares are points on P + D, which hides the same secret, 
+ *  and they can't be combined with shares from before the refresh.
+ * 
+ * @param userShares The shares to refresh.
+ * @param threshold The threshold the secret was split with.
+ * @param randomSource The source of D's coefficients, or null for a new ChaCha20Rng.
+ */
+void ShamirsSecretSharing::refreshShares(std::vector<Share> &userShares, uint64_t threshold, 
+	std::shared_ptr<RandomSource> randomSource) 
+{
+	if (threshold < 2 || threshold > p-1)
+		throw std::domain_error("Error: The threshold (k) is outside the range.");
+
+	std::vector<uint64_t> xValues(userShares.size()), deltas(userShares.size());
+	for (size_t i = 0; i < userShares.size(); i++)
+	{
+		const auto &[xi, yi] = userShares[i];
+		if (xi < 1 || xi > p-1 || yi > p-1)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+		xValues[i] = xi;
+	}
+
+	// 0, d_{1}, ..., d_{k-1}
+	if (!randomSource)
+		randomSource = std::make_shared<ChaCha20Rng>();
+	std::vector<uint64_t> refresh(threshold, 0);
+	randomSource->fillFieldElements(refresh.data() + 1, threshold - 1);
+
+	PolynomialEvaluator::evaluate(refresh.data(), refresh.size(), xValues.data(), deltas.data(), xValues.size());
+	for (size_t i = 0; i < userShares.size(); i++)
+		userShares[i].second = Fp61::add(userShares[i].second, deltas[i]);
+}
+
+
+/**
+ * Issues shares to new holders from k existing shares, once the dealer is gone.
+ *  The polynomial through the shares is evaluated straight at the new 
+ *  x-values, with the work that only depends on the existing shares done 
+ *  once for all of them, so enrolling m holders costs O(k(k+m)). The secret 
+ *  is never computed on its own along the way, and x = 0 is refused because 
+ *  that share would be the secret.
+ * 
+ * @param userShares k or more shares from the same polynomial. With more than 
+ *        k, they must all be correct or the new shares will be wrong.
+ * @param newXValues The x-values of the new shares, in [1, p-1].
+ * 
+ * @return The new shares, in the same order as newXValues.
+ */
+std::vector<Share> ShamirsSecretSharing::enrollShares(const std::vector<Share> &userShares, const std::vector<uint64_t> &newXValues) 
+{
+	if (userShares.empty())
+		throw std::invalid_argument("Error: No shares were provided to enroll from.");
+
+	for (const auto &[xi, yi] : userShares) 
+	{
+		if (xi < 1 || xi > p-1 || yi > p-1)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+	}
+	for (uint64_t x : newXValues) 
+	{
+		if (x < 1 || x > p-1)
+			throw std::domain_error("Error: A new share's x-value is outside the range [1, p-1].");
+	}
 
-	this->shares.reserve(prevSize + numToGenerate);
-	for (uint64_t i = 0; i < numToGenerate; i++) 
+	std::vector<uint64_t> xValues(userShares.size()), yValues(userShares.size());
+	for (size_t i = 0; i < userShares.size(); i++)
 	{
-		uint64_t x = prevSize + i + 1;
-		this->shares.emplace_back(x, evaluatePolynomial(x));
+		xValues[i] = userShares[i].first;
+		yValues[i] = userShares[i].second;
 	}
+
+	std::shared_ptr<ThreadPool> pool;
+	{
+		std::lock_guard<std::mutex> lock(recoveryThreadMutex);
+		pool = recoveryThreadPool;
+	}
+
+	std::vector<uint64_t> newYValues = Lagrange::evaluateAt(xValues, yValues, newXValues, pool.get());
+
+	std::vector<Share> newShares(newXValues.size());
+	for (size_t i = 0; i < newXValues.size(); i++)
+		newShares[i] = {newXValues[i], newYValues[i]};
+
+	return newShares;
 }
 
 
@@ -80,66 +398,111 @@ void ShamirsSecretSharing::generateAdditionalShares(uint64_t numToGenerate)
  */
 uint64_t ShamirsSecretSharing::recoverSecret(const std::vector<Share> &userShares) 
 {
-	uint64_t secret = 0;
+	SSS_STATS_TIMER(RecoverSecret);
 
 	for (const auto &[xi, yi] : userShares) 
 	{
 		if (xi < 1 || xi > p-1 || yi > p-1)
 			throw std::domain_error("Error: A provided share is outside the field range.");
+	}
+
+	std::vector<uint64_t> xValues(userShares.size()), yValues(userShares.size());
+	for (size_t i = 0; i < userShares.size(); i++)
+	{
+		xValues[i] = userShares[i].first;
+		yValues[i] = userShares[i].second;
+	}
+
+	std::shared_ptr<ThreadPool> pool;
+	{
+		std::lock_guard<std::mutex> lock(recoveryThreadMutex);
+		pool = recoveryThreadPool;
+	}
 
-		// Numerator = (x-x_{1})...(x-x_{i-1})(x-x_{i+1})...(x-x_{k})
-		uint64_t numerator = 1;
+	// When the x-values are evenly spaced, such as a block of consecutive 
+	// shares, the weights have a closed form that only takes O(k)
+	uint64_t first, step;
+	if (Lagrange::isArithmeticProgression(xValues, first, step))
+	{
+		RecoveryPlan plan(xValues);
+		return plan.recover(yValues, pool.get());
+	}
 
-		// Denominator = (x_{i}-x_{1})...(x_{i}-x_{i-1})(x_{i}-x_{i+1})...(x_{i}-x_{k})
-		uint64_t denominator = 1;
+	// Otherwise the numerator/denominator fraction of each term only depends 
+	// on the x-values, so the recovery plan for this set of holders is cached
+	std::vector<Share> sorted(userShares);
+	std::sort(sorted.begin(), sorted.end());
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		xValues[i] = sorted[i].first;
+		yValues[i] = sorted[i].second;
+	}
 
-		int equalXCount = 0;
-		for (const auto &[xj, yj] : userShares) 
-		{
-			if (xi == xj)
-			{
-				if (equalXCount > 0)
-					throw std::invalid_argument("Error: Two or more of the provided shares had the same x-value.");
-				equalXCount++;
-				continue;
-			}
-
-			// (x-x_{j}), but x=0 in this case since we want the constant term
-			uint64_t factor = modSubtract(0, xj);
-			numerator = modMultiply(numerator, factor);
-
-			// (x_{i}-x_{j})
-			uint64_t divisor = modSubtract(xi, xj);
-			denominator = modMultiply(denominator, divisor);
-		}
+	std::shared_ptr<const RecoveryPlan> plan = RecoveryPlanCache::global().get(xValues, pool.get());
+	return plan->recover(yValues, pool.get());
+}
 
-		// To compute a/b (mod p), we must calculate a*b^{-1} (mod p)
-		uint64_t fraction = modMultiply(numerator, getMultiplicativeInverse(denominator));
 
-		// Multiply the term's fraction by the y-value of the current share, i
-		uint64_t thisTerm = modMultiply(fraction, yi);
+/**
+ * Recovers the secret even if some of the shares are wrong.
+ *  The shares are a Reed-Solomon codeword, so with n > k shares up to 
+ *  (n-k)/2 corrupted shares can be corrected by decoding, which also shows 
+ *  which shares were wrong.
+ * 
+ * @param userShares The list of shares, with unique x-values.
+ * @param threshold The number of shares needed to recover the secret.
+ * 
+ * @return The secret and the x-values of the faulty shares.
+ */
+RobustRecovery ShamirsSecretSharing::recoverSecretRobust(const std::vector<Share> &userShares, uint64_t threshold) 
+{
+	for (const auto &[xi, yi] : userShares) 
+	{
+		if (xi < 1 || xi > p-1 || yi > p-1)
+			throw std::domain_error("Error: A provided share is outside the field range.");
+	}
+	if (threshold < 1 || userShares.size() < threshold)
+		throw std::invalid_argument("Error: Expected at least k shares.");
 
-		// Add this term to the secret
-		secret = mod(secret + thisTerm);
+	std::vector<uint64_t> xValues(userShares.size()), yValues(userShares.size());
+	for (size_t i = 0; i < userShares.size(); i++)
+	{
+		xValues[i] = userShares[i].first;
+		yValues[i] = userShares[i].second;
 	}
+	Lagrange::checkUnique(xValues);
+
+	Polynomial::Coefficients polynomial;
+	std::vector<size_t> errorPositions;
+	if (!ReedSolomon::decode(xValues, yValues, threshold, polynomial, errorPositions))
+		throw std::invalid_argument("Error: Too many shares are corrupted to recover the secret.");
+
+	RobustRecovery result;
+	result.secret = polynomial.empty() ? 0 : polynomial[0];
+	for (size_t i : errorPositions)
+		result.faultyXValues.push_back(xValues[i]);
+	std::sort(result.faultyXValues.begin(), result.faultyXValues.end());
 
-	return secret;
+	return result;
 }
 
 
 /**
- * Generates k-1 random coefficients.
+ * Generates the polynomial's coefficients: the secret followed by k-1 random 
+ * coefficients. The last one is non-zero so the polynomial has degree k-1.
  * 
- * @return The list of coefficients a_{1}, a_{2}, ..., a_{k-1}
+ * @return The list of coefficients secret, a_{1}, a_{2}, ..., a_{k-1}
  */
 std::vector<uint64_t> ShamirsSecretSharing::generateCoefficients() 
 {
+	SSS_STATS_TIMER(GenerateCoefficients);
+
 	uint64_t degree = threshold-1;
-	std::vector<uint64_t> coefficients(degree, 0);
+	std::vector<uint64_t> coefficients(degree+1, 0);
+	coefficients[0] = secret;
 	
-	for (size_t i = 0; i < degree-1; i++)
-		coefficients[i] = getRandomIntegerInRange(0, p-1);
-	coefficients[degree-1] = getRandomIntegerInRange(1, p-1);
+	randomSource->fillFieldElements(coefficients.data() + 1, degree - 1, 0);
+	randomSource->fillFieldElements(coefficients.data() + degree, 1, 1);
 
 	return coefficients;
 }
@@ -154,36 +517,24 @@ std::vector<uint64_t> ShamirsSecretSharing::generateCoefficients()
  */
 uint64_t ShamirsSecretSharing::evaluatePolynomial(uint64_t x) const 
 {
-	// The secret is the constant term of the polynomial
-	uint64_t yValue = secret;
-
-	uint64_t curX = 1;
-	for (size_t i = 0; i < coefficients.size(); i++) 
-	{
-		// Increase the x exponent by 1
-		curX = modMultiply(curX, x);
-
-		// Multiply by this coefficient
-		uint64_t curTerm = modMultiply(coefficients[i], curX);
-		yValue = mod(yValue+curTerm);
-	}
-
+	uint64_t yValue;
+	evaluatePolynomial(&x, &yValue, 1);
 	return yValue;
 }
 
 
 /**
- * Gets a random integer in the range [min, max]
+ * Calculates the y-values for many x-values at once, using Horner's scheme on
+ * several x-values together.
  * 
- * @param min The minimum value.
- * @param max The maximum value.
- * 
- * @return The random integer.
+ * @param xValues The x-values, in [0, p).
+ * @param yValues Where to write the y-values.
+ * @param count The number of x-values.
  */
-uint64_t ShamirsSecretSharing::getRandomIntegerInRange(uint64_t min, uint64_t max) 
+void ShamirsSecretSharing::evaluatePolynomial(const uint64_t *xValues, uint64_t *yValues, size_t count) const 
 {
-	std::uniform_int_distribution<uint64_t> distribution(min, max);
-	return distribution(rng);
+	SSS_STATS_TIMER(EvaluatePolynomial);
+	PolynomialEvaluator::evaluate(coefficients.data(), coefficients.size(), xValues, yValues, count);
 }
 
 
@@ -201,7 +552,7 @@ uint64_t ShamirsSecretSharing::getMultiplicativeInverse(uint64_t a)
 	if (a == 0)
 		throw std::invalid_argument("Error: 0 has no multiplicative inverse.");
 
-	return modPower(a, p-2);
+	return Fp61::inv(a);
 }
 
 
@@ -217,16 +568,7 @@ uint64_t ShamirsSecretSharing::getMultiplicativeInverse(uint64_t a)
  */
 uint64_t ShamirsSecretSharing::modPower(uint64_t base, uint64_t exp) 
 {
-	uint64_t res = 1, b = base;
-
-	for (; exp > 0; exp >>= 1) 
-	{
-		if (exp & 1)
-			res = modMultiply(res, b);
-		b = modMultiply(b, b);
-	}
-
-	return res;
+	return Fp61::pow(base, exp);
 }
 
 
@@ -240,7 +582,7 @@ uint64_t ShamirsSecretSharing::modPower(uint64_t base, uint64_t exp)
  */
 uint64_t ShamirsSecretSharing::modSubtract(uint64_t a, uint64_t b) 
 {
-	return mod(a + p - b);
+	return Fp61::sub(a, b);
 }
 
 
@@ -254,12 +596,13 @@ uint64_t ShamirsSecretSharing::modSubtract(uint64_t a, uint64_t b)
  */
 uint64_t ShamirsSecretSharing::modMultiply(uint64_t a, uint64_t b) 
 {
-	return static_cast<uint64_t>(mod(__uint128_t(a) * b));
+	return Fp61::mul(a, b);
 }
 
 
 /**
  * Computes a (mod p). Overloads for uint64_t or __uint128_t.
+ *  Uses the Mersenne shift-and-add reduction rather than a division.
  * 
  * @param a
  * 
@@ -267,10 +610,10 @@ uint64_t ShamirsSecretSharing::modMultiply(uint64_t a, uint64_t b)
  */
 uint64_t ShamirsSecretSharing::mod(uint64_t a) 
 {
-	return a % p;
+	return Fp61::reduce(a);
 }
 
 uint64_t ShamirsSecretSharing::mod(__uint128_t a) 
 {
-	return static_cast<uint64_t>(a % p);
+	return Fp61::reduce(a);
 }
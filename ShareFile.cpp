@@ -0,0 +1,287 @@
+#include "share-file.h"
+#include "fp61.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The y-words are used in place, so they must already be in host order
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Share files are mapped as little-endian words.");
+
+
+static const char fileMagic[4] = {'S', 'S', 'S', 'F'};
+
+// An arbitrary field element, the base of the checksum's polynomial hash
+static constexpr uint64_t checksumBase = 0x0DDB1A5E5BAD5EEDULL % Fp61::p;
+
+
+static void putWord(unsigned char *bytes, uint64_t word, int numBytes) 
+{
+	for (int b = 0; b < numBytes; b++)
+		bytes[b] = static_cast<unsigned char>(word >> (8*b));
+}
+
+static uint64_t getWord(const unsigned char *bytes, int numBytes) 
+{
+	uint64_t word = 0;
+	for (int b = 0; b < numBytes; b++)
+		word |= uint64_t(bytes[b]) << (8*b);
+	return word;
+}
+
+
+/**
+ * Hashes the y-words and then the header fields as the coefficients of a 
+ * polynomial evaluated at checksumBase. Each word is split into 32-bit halves 
+ * so that every word, even one outside the field, changes the hash.
+ */
+uint64_t ShareFile::checksum(Layout layout, uint64_t threshold, uint64_t firstX, const uint64_t *yValues, size_t count) 
+{
+	return checksumHeader(checksumWords(0, yValues, count), layout, threshold, firstX, count);
+}
+
+uint64_t ShareFile::checksumWords(uint64_t hash, const uint64_t *words, size_t count) 
+{
+	for (size_t i = 0; i < count; i++) 
+	{
+		hash = Fp61::add(Fp61::mul(hash, checksumBase), words[i] & 0xFFFFFFFF);
+		hash = Fp61::add(Fp61::mul(hash, checksumBase), words[i] >> 32);
+	}
+	return hash;
+}
+
+uint64_t ShareFile::checksumHeader(uint64_t hash, Layout layout, uint64_t threshold, uint64_t firstX, size_t count) 
+{
+	uint64_t fields[] = {(uint64_t(fieldFp61) << 16) | version, static_cast<uint64_t>(layout), threshold, firstX, count};
+	return checksumWords(hash, fields, sizeof(fields) / sizeof(fields[0]));
+}
+
+
+void ShareFile::writeHeader(std::ostream &out, Layout layout, uint64_t threshold, uint64_t firstX, 
+	size_t count, uint64_t checksum) 
+{
+	unsigned char header[headerBytes] = {};
+	std::memcpy(header, fileMagic, sizeof(fileMagic));
+	putWord(header + 4, version, 2);
+	putWord(header + 6, fieldFp61, 2);
+	putWord(header + 8, static_cast<uint64_t>(layout), 8);
+	putWord(header + 16, threshold, 8);
+	putWord(header + 24, firstX, 8);
+	putWord(header + 32, count, 8);
+	putWord(header + 40, checksum, 8);
+	out.write(reinterpret_cast<const char*>(header), headerBytes);
+}
+
+
+/**
+ * Writes shares to a new share file, replacing any existing file.
+ * 
+ * @param path The file to write.
+ * @param layout Whether the shares are one secret's range or one holder's column.
+ * @param threshold The threshold the shares were made with.
+ * @param firstX The first x-value of a range, or the holder's x-value.
+ * @param yValues The y-values.
+ * @param count The number of y-values.
+ */
+void ShareFile::write(const std::string &path, Layout layout, uint64_t threshold, uint64_t firstX, 
+	const uint64_t *yValues, size_t count) 
+{
+	ShareFileWriter writer(path, layout, threshold, firstX);
+	writer.append(yValues, count);
+	writer.close();
+}
+
+
+void ShareFile::write(const std::string &path, const CompactShares &shares, uint64_t threshold) 
+{
+	if (shares.getLayout() == CompactShares::Layout::Words) 
+	{
+		write(path, Layout::Range, threshold, shares.getFirstX(), shares.data(), shares.size());
+		return;
+	}
+
+	std::vector<uint64_t> yValues(shares.size());
+	shares.copyY(0, shares.size(), yValues.data());
+	write(path, Layout::Range, threshold, shares.getFirstX(), yValues.data(), yValues.size());
+}
+
+
+/**
+ * Maps a share file and checks its header. The y-values are not read, so 
+ * opening costs the same for any size of file.
+ * 
+ * @param path The file to open.
+ */
+ShareFile::ShareFile(const std::string &path) 
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("Error: Couldn't open the share file " + path + ": " + std::strerror(errno));
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(headerBytes)) 
+	{
+		::close(fd);
+		throw std::invalid_argument("Error: " + path + " is too short to be a share file.");
+	}
+
+	this->mapBytes = static_cast<size_t>(status.st_size);
+	void *mapped = ::mmap(nullptr, this->mapBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		throw std::runtime_error("Error: Couldn't map the share file " + path + ": " + std::strerror(errno));
+	this->map = static_cast<const unsigned char*>(mapped);
+
+	const unsigned char *header = this->map;
+	uint64_t layout = getWord(header + 8, 8);
+	this->threshold = getWord(header + 16, 8);
+	this->firstX = getWord(header + 24, 8);
+	this->count = getWord(header + 32, 8);
+	this->storedChecksum = getWord(header + 40, 8);
+
+	const char *problem = nullptr;
+	if (std::memcmp(header, fileMagic, sizeof(fileMagic)) != 0)
+		problem = " is not a share file.";
+	else if (getWord(header + 4, 2) != version)
+		problem = " has an unsupported version.";
+	else if (getWord(header + 6, 2) != fieldFp61)
+		problem = " is for an unsupported field.";
+	else if (layout > static_cast<uint64_t>(Layout::Column))
+		problem = " has an unknown layout.";
+	else if (this->count != (this->mapBytes - headerBytes) / sizeof(uint64_t) || (this->mapBytes - headerBytes) % sizeof(uint64_t) != 0)
+		problem = " doesn't match the number of shares in its header.";
+	else if (this->firstX < 1 || this->firstX > Fp61::p-1)
+		problem = " has a first x-value outside the field range.";
+
+	if (problem) 
+	{
+		unmap();
+		throw std::invalid_argument("Error: " + path + problem);
+	}
+	this->layout = static_cast<Layout>(layout);
+}
+
+
+ShareFile::ShareFile(ShareFile &&other) noexcept 
+{
+	*this = std::move(other);
+}
+
+ShareFile& ShareFile::operator=(ShareFile &&other) noexcept 
+{
+	if (this != &other) 
+	{
+		unmap();
+		this->map = std::exchange(other.map, nullptr);
+		this->mapBytes = std::exchange(other.mapBytes, 0);
+		this->layout = other.layout;
+		this->threshold = other.threshold;
+		this->firstX = other.firstX;
+		this->count = std::exchange(other.count, 0);
+		this->storedChecksum = other.storedChecksum;
+	}
+	return *this;
+}
+
+ShareFile::~ShareFile() 
+{
+	unmap();
+}
+
+void ShareFile::unmap() 
+{
+	if (this->map)
+		::munmap(const_cast<unsigned char*>(this->map), this->mapBytes);
+	this->map = nullptr;
+	this->mapBytes = 0;
+}
+
+
+ShareFile::Layout ShareFile::getLayout() const 
+{
+	return this->layout;
+}
+
+uint64_t ShareFile::getThreshold() const 
+{
+	return this->threshold;
+}
+
+uint64_t ShareFile::getFirstX() const 
+{
+	return this->firstX;
+}
+
+size_t ShareFile::size() const 
+{
+	return this->count;
+}
+
+const uint64_t* ShareFile::getYValues() const 
+{
+	return reinterpret_cast<const uint64_t*>(this->map + headerBytes);
+}
+
+
+bool ShareFile::verifyChecksum() const 
+{
+	return checksum(this->layout, this->threshold, this->firstX, getYValues(), this->count) == this->storedChecksum;
+}
+
+
+/**
+ * Creates the file, with a blank header until close() is called.
+ * 
+ * @param path The file to write, replacing any existing file.
+ * @param layout Whether the shares are one secret's range or one holder's column.
+ * @param threshold The threshold the shares were made with.
+ * @param firstX The first x-value of a range, or the holder's x-value.
+ */
+ShareFileWriter::ShareFileWriter(const std::string &path, ShareFile::Layout layout, uint64_t threshold, uint64_t firstX) 
+: out(path, std::ios::binary | std::ios::trunc), path(path), layout(layout), threshold(threshold), firstX(firstX) 
+{
+	if (firstX < 1 || firstX > Fp61::p-1)
+		throw std::domain_error("Error: The first x-value is outside the field range.");
+	if (!this->out)
+		throw std::runtime_error("Error: Couldn't create the share file " + path + ".");
+
+	const char blank[ShareFile::headerBytes] = {};
+	this->out.write(blank, sizeof(blank));
+}
+
+
+size_t ShareFileWriter::size() const 
+{
+	return this->count;
+}
+
+
+void ShareFileWriter::append(const uint64_t *yValues, size_t count) 
+{
+	if (this->layout == ShareFile::Layout::Range && count > Fp61::p - this->firstX - this->count)
+		throw std::domain_error("Error: The number of shares is outside the range.");
+
+	this->out.write(reinterpret_cast<const char*>(yValues), count * sizeof(uint64_t));
+	this->hash = ShareFile::checksumWords(this->hash, yValues, count);
+	this->count += count;
+}
+
+
+void ShareFileWriter::close() 
+{
+	uint64_t checksum = ShareFile::checksumHeader(this->hash, this->layout, this->threshold, this->firstX, this->count);
+	this->out.seekp(0);
+	ShareFile::writeHeader(this->out, this->layout, this->threshold, this->firstX, this->count, checksum);
+	this->out.close();
+
+	if (!this->out)
+		throw std::runtime_error("Error: Couldn't write the share file " + this->path + ".");
+}
@@ -0,0 +1,126 @@
+#include "share-range.h"
+#include "fp61.h"
+#include "polynomial-evaluator.h"
+
+#include <stdexcept>
+
+
+ShareRange::ShareRange(const std::vector<uint64_t> &coefficients, uint64_t firstX, size_t count) 
+: coefficients(coefficients), firstX(firstX), count(count) 
+{
+	if (firstX < 1 || firstX > Fp61::p-1)
+		throw std::domain_error("Error: A requested x-value is outside the field range.");
+	if (count > Fp61::p - firstX)
+		throw std::domain_error("Error: The number of shares requested is outside the range.");
+}
+
+
+uint64_t ShareRange::getFirstX() const 
+{
+	return this->firstX;
+}
+
+size_t ShareRange::size() const 
+{
+	return this->count;
+}
+
+bool ShareRange::empty() const 
+{
+	return this->count == 0;
+}
+
+
+/**
+ * Computes the i-th share of the range, at x = firstX + i.
+ */
+Share ShareRange::operator[](size_t i) const 
+{
+	uint64_t x = this->firstX + i;
+	return {x, evaluate(x)};
+}
+
+Share ShareRange::at(size_t i) const 
+{
+	if (i >= this->count)
+		throw std::out_of_range("Error: The share is outside the range.");
+	return (*this)[i];
+}
+
+
+/**
+ * A view of part of this range, sharing nothing with it.
+ * 
+ * @param offset The index of the first share in this range.
+ * @param count The number of shares.
+ */
+ShareRange ShareRange::subrange(size_t offset, size_t count) const 
+{
+	if (offset > this->count || count > this->count - offset)
+		throw std::out_of_range("Error: The subrange is outside the range.");
+	return ShareRange(this->coefficients, this->firstX + offset, count);
+}
+
+
+ShareRange::const_iterator ShareRange::begin() const 
+{
+	return const_iterator(this, 0);
+}
+
+ShareRange::const_iterator ShareRange::end() const 
+{
+	return const_iterator(this, this->count);
+}
+
+
+/**
+ * Reads the share under the iterator.
+ *  Stepping forward continues the difference table. After a jump, or at the 
+ *  start, the table is only set up if enough shares remain to pay for it.
+ *  Reading end() throws, rather than running past the range.
+ */
+Share ShareRange::const_iterator::operator*() const 
+{
+	if (this->index >= this->range->count)
+		throw std::out_of_range("Error: The iterator is outside the range.");
+
+	uint64_t x = this->range->firstX + this->index;
+	if (this->current.first == x)
+		return this->current;
+
+	if (this->table.isEmpty() || this->table.getNextX() != x) 
+	{
+		if (this->range->count - this->index < 2*this->range->coefficients.size()) 
+		{
+			this->current = {x, this->range->evaluate(x)};
+			return this->current;
+		}
+		this->table = this->range->makeDifferenceTable(x);
+	}
+
+	this->current = {x, this->table.next()};
+	return this->current;
+}
+
+
+uint64_t ShareRange::evaluate(uint64_t x) const 
+{
+	uint64_t y;
+	PolynomialEvaluator::evaluate(this->coefficients.data(), this->coefficients.size(), &x, &y, 1);
+	return y;
+}
+
+
+/**
+ * Sets up a forward difference table from P(x), ..., P(x+k-1).
+ */
+DifferenceTable ShareRange::makeDifferenceTable(uint64_t x) const 
+{
+	size_t k = this->coefficients.size();
+	std::vector<uint64_t> xValues(k), values(k);
+	for (size_t i = 0; i < k; i++)
+		xValues[i] = Fp61::reduce(x + i);
+	PolynomialEvaluator::evaluate(this->coefficients.data(), k, xValues.data(), values.data(), k);
+
+	return DifferenceTable(x, values);
+}
@@ -0,0 +1,215 @@
+#include "share-stream.h"
+#include "batch-dealer.h"
+#include "fp61.h"
+#include "recovery-plan.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+static const char streamMagic[4] = {'S', 'S', 'S', '1'};
+
+
+static void writeWord(std::ostream &out, uint64_t word) 
+{
+	char bytes[8];
+	for (int b = 0; b < 8; b++)
+		bytes[b] = static_cast<char>(word >> (8*b));
+	out.write(bytes, 8);
+}
+
+
+/**
+ * Reads up to count little-endian words from a stream.
+ * 
+ * @return The number of whole words read.
+ */
+static size_t readWords(std::istream &in, uint64_t *words, size_t count) 
+{
+	std::vector<unsigned char> bytes(count * 8);
+	in.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+
+	size_t bytesRead = static_cast<size_t>(in.gcount());
+	if (bytesRead % 8 != 0)
+		throw std::invalid_argument("Error: A share stream ended part way through a share.");
+
+	for (size_t i = 0; i < bytesRead / 8; i++) 
+	{
+		uint64_t word = 0;
+		for (int b = 0; b < 8; b++)
+			word |= uint64_t(bytes[8*i + b]) << (8*b);
+		words[i] = word;
+	}
+
+	return bytesRead / 8;
+}
+
+
+/**
+ * Splits a byte stream between holders with x-values [1, 2, ..., n].
+ * 
+ * @param secret The stream of secret bytes, read until it ends.
+ * @param holders One output stream per holder.
+ * @param threshold The number of holders needed to recover the secret (k), in [2, n].
+ */
+void ShareStream::split(std::istream &secret, const std::vector<std::ostream*> &holders, uint64_t threshold) 
+{
+	// Checked before any header is written, so a bad split leaves the holders' streams empty
+	if (threshold < 2 || threshold > holders.size())
+		throw std::domain_error("Error: The threshold (k) is outside the range [2, n].");
+
+	std::vector<uint64_t> xValues(holders.size());
+	for (size_t h = 0; h < holders.size(); h++) 
+	{
+		xValues[h] = h+1;
+		holders[h]->write(streamMagic, sizeof(streamMagic));
+		writeWord(*holders[h], xValues[h]);
+		writeWord(*holders[h], threshold);
+	}
+
+	std::vector<unsigned char> bytes(blockLimbs * limbBytes);
+	std::vector<uint64_t> limbs;
+	uint64_t length = 0;
+
+	bool finished = false;
+	while (!finished) 
+	{
+		secret.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+		size_t bytesRead = static_cast<size_t>(secret.gcount());
+		length += bytesRead;
+		finished = bytesRead < bytes.size();
+
+		// Cut the block into little-endian limbs, zero padding the last one
+		limbs.assign((bytesRead + limbBytes-1) / limbBytes, 0);
+		for (size_t i = 0; i < bytesRead; i++)
+			limbs[i / limbBytes] |= uint64_t(bytes[i]) << (8 * (i % limbBytes));
+
+		// The length is shared after the final limb
+		if (finished)
+			limbs.push_back(length);
+		if (limbs.empty())
+			continue;
+
+		BatchDealer dealer(limbs, threshold);
+		dealer.generateShares(xValues);
+		for (size_t h = 0; h < holders.size(); h++) 
+		{
+			const uint64_t *column = dealer.getColumn(h);
+			for (size_t i = 0; i < limbs.size(); i++)
+				writeWord(*holders[h], column[i]);
+		}
+	}
+
+	for (std::ostream *holder : holders) 
+	{
+		holder->flush();
+		if (!*holder)
+			throw std::runtime_error("Error: Failed to write a share stream.");
+	}
+}
+
+
+/**
+ * Combines k or more holders' share streams and writes the original bytes.
+ *  The streams are read in lockstep. The last two words of what has been read
+ *  are always held back, because the final limb can only be trimmed once the 
+ *  length that follows it has been recovered.
+ * 
+ * @param holders One input stream per holder.
+ * @param secret The stream to write the secret bytes to.
+ */
+void ShareStream::combine(const std::vector<std::istream*> &holders, std::ostream &secret) 
+{
+	size_t n = holders.size();
+	std::vector<uint64_t> xValues(n);
+	uint64_t threshold = 0;
+
+	for (size_t h = 0; h < n; h++) 
+	{
+		char magic[sizeof(streamMagic)];
+		holders[h]->read(magic, sizeof(magic));
+		uint64_t header[2];
+		if (!*holders[h] || !std::equal(magic, magic + sizeof(magic), streamMagic) || readWords(*holders[h], header, 2) != 2)
+			throw std::invalid_argument("Error: A share stream has an invalid header.");
+
+		xValues[h] = header[0];
+		if (h > 0 && header[1] != threshold)
+			throw std::invalid_argument("Error: The share streams have different thresholds.");
+		threshold = header[1];
+	}
+	if (n == 0 || n < threshold)
+		throw std::invalid_argument("Error: Fewer than k share streams were provided.");
+
+	RecoveryPlan plan(xValues);
+	const std::vector<uint64_t> &weights = plan.getWeights();
+
+	// pending[h] holds holder h's words which haven't been recovered yet
+	std::vector<std::vector<uint64_t>> pending(n);
+	std::vector<uint64_t> limbs;
+	std::vector<unsigned char> bytes;
+	uint64_t written = 0;
+
+	bool finished = false;
+	while (!finished) 
+	{
+		size_t wordsRead = 0;
+		for (size_t h = 0; h < n; h++) 
+		{
+			size_t held = pending[h].size();
+			pending[h].resize(held + blockLimbs);
+			size_t count = readWords(*holders[h], pending[h].data() + held, blockLimbs);
+			pending[h].resize(held + count);
+
+			if (h > 0 && count != wordsRead)
+				throw std::invalid_argument("Error: The share streams have different lengths.");
+			wordsRead = count;
+		}
+		finished = wordsRead < blockLimbs;
+
+		size_t available = pending[0].size();
+		size_t ready = finished ? available : std::max<size_t>(available, 2) - 2;
+
+		// limbs = w_{1}y_{1} + ... + w_{n}y_{n} for every word, one holder at a time
+		limbs.assign(ready, 0);
+		for (size_t h = 0; h < n; h++) 
+		{
+			for (size_t i = 0; i < ready; i++)
+			{
+				if (pending[h][i] > Fp61::p-1)
+					throw std::domain_error("Error: A provided share is outside the field range.");
+				limbs[i] = Fp61::add(limbs[i], Fp61::mul(weights[h], pending[h][i]));
+			}
+			pending[h].erase(pending[h].begin(), pending[h].begin() + ready);
+		}
+
+		size_t dataLimbs = ready;
+		uint64_t remaining = ~0ULL;
+		if (finished) 
+		{
+			// The final word is the length
+			if (ready == 0)
+				throw std::invalid_argument("Error: The share streams are missing the secret's length.");
+			uint64_t length = limbs[--dataLimbs];
+			if (length < written || (length - written + limbBytes-1) / limbBytes != dataLimbs)
+				throw std::invalid_argument("Error: The recovered length doesn't match the share streams.");
+			remaining = length - written;
+		}
+
+		bytes.resize(dataLimbs * limbBytes);
+		for (size_t i = 0; i < dataLimbs; i++) 
+		{
+			if (limbs[i] >> (8*limbBytes))
+				throw std::invalid_argument("Error: A recovered limb is outside the byte range.");
+			for (size_t b = 0; b < limbBytes; b++)
+				bytes[i*limbBytes + b] = static_cast<unsigned char>(limbs[i] >> (8*b));
+		}
+
+		size_t toWrite = static_cast<size_t>(std::min<uint64_t>(bytes.size(), remaining));
+		secret.write(reinterpret_cast<const char*>(bytes.data()), toWrite);
+		written += toWrite;
+	}
+
+	secret.flush();
+	if (!secret)
+		throw std::runtime_error("Error: Failed to write the secret.");
+}
@@ -0,0 +1,217 @@
+#include "stats.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+
+// Guards the list of live threads and the totals of exited threads
+static std::mutex registryMutex;
+static Stats::Snapshot retired;
+
+// Set once a thread's slots are destroyed, so late allocations aren't counted
+static thread_local bool threadExiting = false;
+
+static const char* counterNames[] = {
+	"multiplications", "exponentiations", "inversions", "batchInversions",
+	"sharesGenerated", "allocations", "bytesAllocated"
+};
+
+static const char* timerNames[] = {
+	"generateCoefficients", "evaluatePolynomial", "generateAdditionalShares",
+	"recoverSecret", "inversion"
+};
+
+static_assert(sizeof(counterNames) / sizeof(counterNames[0]) == Stats::numCounters, "Every counter needs a name.");
+static_assert(sizeof(timerNames) / sizeof(timerNames[0]) == Stats::numTimers, "Every timer needs a name.");
+
+Stats::ThreadStats *Stats::newestThread = nullptr;
+
+
+Stats::ThreadStats::ThreadStats()
+{
+	std::lock_guard<std::mutex> lock(registryMutex);
+	this->previous = newestThread;
+	if (newestThread)
+		newestThread->next = this;
+	newestThread = this;
+}
+
+
+/**
+ * Folds the exiting thread's totals into retired and unlinks it.
+ */
+Stats::ThreadStats::~ThreadStats()
+{
+	threadExiting = true;
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (size_t i = 0; i < numCounters; i++)
+		retired.counters[i] += this->counters[i].load(std::memory_order_relaxed);
+	for (size_t i = 0; i < numTimers; i++)
+	{
+		retired.timerCalls[i] += this->timerCalls[i].load(std::memory_order_relaxed);
+		retired.timerNanoseconds[i] += this->timerNanoseconds[i].load(std::memory_order_relaxed);
+	}
+
+	if (this->previous)
+		this->previous->next = this->next;
+	if (this->next)
+		this->next->previous = this->previous;
+	else
+		newestThread = this->previous;
+}
+
+
+/**
+ * Adds up the counters and timers of every thread, live or exited.
+ *  Live threads keep counting while this runs, so their totals are only as
+ *  of some moment during the call.
+ *
+ * @return The totals since the start, or since the last reset().
+ */
+Stats::Snapshot Stats::snapshot()
+{
+	std::lock_guard<std::mutex> lock(registryMutex);
+	Snapshot total = retired;
+	for (const ThreadStats *stats = newestThread; stats; stats = stats->previous)
+	{
+		for (size_t i = 0; i < numCounters; i++)
+			total.counters[i] += stats->counters[i].load(std::memory_order_relaxed);
+		for (size_t i = 0; i < numTimers; i++)
+		{
+			total.timerCalls[i] += stats->timerCalls[i].load(std::memory_order_relaxed);
+			total.timerNanoseconds[i] += stats->timerNanoseconds[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	return total;
+}
+
+
+/**
+ * Zeroes every counter and timer. Counts made by other threads while this
+ * runs may be lost, so call it when no work is in progress.
+ */
+void Stats::reset()
+{
+	std::lock_guard<std::mutex> lock(registryMutex);
+	retired = Snapshot();
+	for (ThreadStats *stats = newestThread; stats; stats = stats->previous)
+	{
+		for (auto &counter : stats->counters)
+			counter.store(0, std::memory_order_relaxed);
+		for (size_t i = 0; i < numTimers; i++)
+		{
+			stats->timerCalls[i].store(0, std::memory_order_relaxed);
+			stats->timerNanoseconds[i].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+
+/**
+ * Counts one allocation, unless the calling thread is already exiting.
+ *
+ * @param bytes The size requested.
+ */
+void Stats::addAllocation(size_t bytes)
+{
+	if (threadExiting)
+		return;
+
+	add(Counter::Allocations, 1);
+	add(Counter::BytesAllocated, bytes);
+}
+
+
+/**
+ * The change in every counter and timer since an earlier snapshot.
+ */
+Stats::Snapshot Stats::Snapshot::operator-(const Snapshot &before) const
+{
+	Snapshot difference;
+	for (size_t i = 0; i < numCounters; i++)
+		difference.counters[i] = this->counters[i] - before.counters[i];
+	for (size_t i = 0; i < numTimers; i++)
+	{
+		difference.timerCalls[i] = this->timerCalls[i] - before.timerCalls[i];
+		difference.timerNanoseconds[i] = this->timerNanoseconds[i] - before.timerNanoseconds[i];
+	}
+
+	return difference;
+}
+
+
+const char* Stats::name(Counter counter)
+{
+	return counterNames[static_cast<size_t>(counter)];
+}
+
+const char* Stats::name(Timer timer)
+{
+	return timerNames[static_cast<size_t>(timer)];
+}
+
+
+#ifdef SSS_STATS
+
+// The global allocation functions are replaced to count every allocation.
+// The matching deallocation functions are replaced too, so memory from
+// malloc is always released with free.
+
+void* operator new(size_t size)
+{
+	Stats::addAllocation(size);
+	if (void *memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	Stats::addAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t &tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "thread-pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+/**
+ * The constructor.
+ *  Starts numThreads-1 workers, since the caller of parallelFor also works.
+ * 
+ * @param numThreads The total number of threads to split work across.
+ */
+ThreadPool::ThreadPool(unsigned numThreads) 
+{
+	if (numThreads < 1)
+		throw std::domain_error("Error: The number of threads must be at least 1.");
+
+	for (unsigned i = 1; i < numThreads; i++)
+		this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() 
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+
+	for (std::thread &worker : this->workers)
+		worker.join();
+}
+
+
+unsigned ThreadPool::size() const 
+{
+	return static_cast<unsigned>(this->workers.size()) + 1;
+}
+
+
+/**
+ * Splits [0, count) into one contiguous range per thread and runs the task on
+ * every range. Blocks until all ranges are finished, and rethrows the first
+ * exception thrown by any of them. Calls from several threads are run one at
+ * a time.
+ * 
+ * @param count The number of items.
+ * @param task Called as task(begin, end) for each non-empty range.
+ */
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)> &task) 
+{
+	if (this->workers.empty())
+	{
+		if (count > 0)
+			task(0, count);
+		return;
+	}
+
+	std::lock_guard<std::mutex> callLock(this->callMutex);
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->task = &task;
+		this->count = count;
+		this->remaining = static_cast<unsigned>(this->workers.size());
+		this->error = nullptr;
+		this->generation++;
+	}
+	this->wake.notify_all();
+
+	// The calling thread takes the first range
+	std::exception_ptr callerError;
+	try 
+	{
+		runRange(0, count, task);
+	} 
+	catch (...) 
+	{
+		callerError = std::current_exception();
+	}
+
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->done.wait(lock, [this] { return this->remaining == 0; });
+	this->task = nullptr;
+
+	if (callerError)
+		std::rethrow_exception(callerError);
+	if (this->error)
+		std::rethrow_exception(this->error);
+}
+
+
+void ThreadPool::runRange(unsigned index, size_t count, const std::function<void(size_t, size_t)> &task) 
+{
+	// The first count % threads ranges get one extra item
+	size_t threads = size();
+	size_t base = count / threads, extra = count % threads;
+	size_t begin = index * base + std::min<size_t>(index, extra);
+	size_t end = begin + base + (index < extra ? 1 : 0);
+
+	if (begin < end)
+		task(begin, end);
+}
+
+
+void ThreadPool::workerLoop(unsigned index) 
+{
+	unsigned long seenGeneration = 0;
+
+	while (true) 
+	{
+		const std::function<void(size_t, size_t)> *task;
+		size_t count;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->wake.wait(lock, [&] { return this->stopping || this->generation != seenGeneration; });
+			if (this->stopping)
+				return;
+
+			seenGeneration = this->generation;
+			task = this->task;
+			count = this->count;
+		}
+
+		std::exception_ptr taskError;
+		try 
+		{
+			runRange(index, count, *task);
+		} 
+		catch (...) 
+		{
+			taskError = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (taskError && !this->error)
+			this->error = taskError;
+		if (--this->remaining == 0)
+			this->done.notify_one();
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef SHAMIRS_SECRET_SHARING_BATCH_DEALER_H
+#define SHAMIRS_SECRET_SHARING_BATCH_DEALER_H
+
+#include "random-source.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Splits many secrets at once with a common threshold and set of holders.
+ *  The polynomials are stored as a coefficient-major matrix, so row j holds
+ *  the j-th coefficient of every secret. Shares are stored as one contiguous
+ *  column of y-values per holder, so column h holds holder h's share of 
+ *  every secret.
+ */
+class BatchDealer {
+public:
+	BatchDealer(const std::vector<uint64_t> &secrets, uint64_t threshold, 
+		std::shared_ptr<RandomSource> randomSource = nullptr);
+
+	size_t getNumSecrets() const;
+	uint64_t getThreshold() const;
+	void generateShares(const std::vector<uint64_t> &newXValues);
+	const std::vector<uint64_t>& getXValues() const;
+	const uint64_t* getColumn(size_t holder) const;
+
+	static std::vector<uint64_t> recoverSecrets(const std::vector<uint64_t> &xValues, 
+		const std::vector<const uint64_t*> &columns, size_t numSecrets);
+	static void refreshShares(const std::vector<uint64_t> &xValues, 
+		const std::vector<uint64_t*> &columns, size_t numSecrets, uint64_t threshold, 
+		std::shared_ptr<RandomSource> randomSource = nullptr);
+
+private:
+	size_t numSecrets;
+	uint64_t threshold;
+
+	// A ChaCha20 CSPRNG unless another source was given
+	std::shared_ptr<RandomSource> randomSource;
+
+	// threshold rows of numSecrets coefficients, row 0 holds the secrets
+	std::vector<uint64_t> coefficients;
+
+	std::vector<uint64_t> xValues;
+	std::vector<uint64_t> columns;
+
+	void generateCoefficients(const std::vector<uint64_t> &secrets);
+	static void evaluatePolynomials(const uint64_t *coefficients, size_t threshold, size_t numSecrets, 
+		uint64_t x, uint64_t *yValues);
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef SHAMIRS_SECRET_SHARING_BOUNDED_QUEUE_H
+#define SHAMIRS_SECRET_SHARING_BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * A fixed-capacity queue for many producers and many consumers, without locks.
+ *  Every cell carries a sequence number saying whether it is ready to be 
+ *  written or read on the current lap around the ring, so a producer or 
+ *  consumer claims a cell with one compare-and-swap on its own position and 
+ *  never waits on the other side. The capacity is rounded up to a power of 2.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+	explicit BoundedQueue(size_t capacity) 
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+
+		this->cells.reset(new Cell[size]);
+		this->mask = size - 1;
+		for (size_t i = 0; i < size; i++)
+			this->cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+
+	/**
+	 * Adds a value unless the queue is full.
+	 * 
+	 * @param value The value, which is moved from only on success.
+	 * 
+	 * @return False if the queue was full.
+	 */
+	bool tryPush(T &value) 
+	{
+		size_t position = this->enqueuePosition.load(std::memory_order_relaxed);
+		while (true) 
+		{
+			Cell &cell = this->cells[position & this->mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			ptrdiff_t lap = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+
+			if (lap == 0) 
+			{
+				if (this->enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) 
+				{
+					cell.value = std::move(value);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (lap < 0)
+				return false;
+			else
+				position = this->enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+
+	/**
+	 * Removes the oldest value unless the queue is empty.
+	 * 
+	 * @param value Set to the value removed.
+	 * 
+	 * @return False if the queue was empty.
+	 */
+	bool tryPop(T &value) 
+	{
+		size_t position = this->dequeuePosition.load(std::memory_order_relaxed);
+		while (true) 
+		{
+			Cell &cell = this->cells[position & this->mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			ptrdiff_t lap = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position + 1);
+
+			if (lap == 0) 
+			{
+				if (this->dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) 
+				{
+					value = std::move(cell.value);
+					cell.sequence.store(position + this->mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (lap < 0)
+				return false;
+			else
+				position = this->dequeuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+
+	// On separate cache lines so producers and consumers don't false-share
+	alignas(64) std::atomic<size_t> enqueuePosition{0};
+	alignas(64) std::atomic<size_t> dequeuePosition{0};
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef SHAMIRS_SECRET_SHARING_BULK_PROCESSOR_H
+#define SHAMIRS_SECRET_SHARING_BULK_PROCESSOR_H
+
+#include "thread-pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class TextReader;
+
+/**
+ * Splits and combines many secrets in one run, for batch jobs.
+ *  The input is handled in chunks of records. While one chunk is computed 
+ *  across the thread pool, the next chunk is read and the previous one is 
+ *  written, so I/O overlaps computation. The text formats have one record 
+ *  per line:
+ * 
+ *    secrets:  S
+ *    shares:   x_{1} y_{1} x_{2} y_{2} ... x_{n} y_{n}
+ * 
+ *  The binary format is one Column share file per holder (see share-file.h).
+ */
+class BulkProcessor {
+public:
+	explicit BulkProcessor(unsigned numThreads);
+
+	void split(std::istream &secrets, std::ostream &shares, uint64_t threshold, uint64_t numShares);
+	void splitToFiles(std::istream &secrets, const std::string &prefix, uint64_t threshold, uint64_t numShares);
+	void combine(std::istream &shares, std::ostream &secrets);
+	void combineFiles(const std::vector<std::string> &paths, std::ostream &secrets);
+
+	// The number of records read, computed and written together
+	static constexpr size_t chunkRecords = 1 << 16;
+
+private:
+	ThreadPool pool;
+
+	struct Chunk {
+		// The numbers of every record, back to back, and where each record ends
+		std::vector<uint64_t> values;
+		std::vector<size_t> recordEnds;
+
+		// The index of the chunk's first record in the whole input
+		size_t first = 0;
+
+		// The output, as one piece of text per thread or as holder-major y-values
+		std::vector<std::string> text;
+		std::vector<uint64_t> columns;
+
+		size_t size() const { return recordEnds.size(); }
+	};
+
+	void runPipeline(const std::function<bool(Chunk&)> &read, const std::function<void(Chunk&)> &compute, 
+		const std::function<void(Chunk&)> &write);
+	void splitChunk(Chunk &chunk, uint64_t threshold, uint64_t numShares, bool formatText);
+	static bool readRecords(TextReader &reader, Chunk &chunk);
+	static void writeText(std::ostream &out, const Chunk &chunk);
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SHAMIRS_SECRET_SHARING_COMPACT_SHARES_H
+#define SHAMIRS_SECRET_SHARING_COMPACT_SHARES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+using Share = std::pair<uint64_t, uint64_t>;
+
+/**
+ * Shares at consecutive x-values firstX, firstX+1, ..., stored as y-values 
+ * only. The x-values are implicit, so a share takes 8 bytes instead of 16, 
+ * or 61 bits when bit-packed. Reading a share yields an ordinary Share pair.
+ */
+class CompactShares {
+public:
+	// Words stores each y-value in its own 64-bit word, Packed61 stores them 
+	// back to back in 61 bits each
+	enum class Layout { Words, Packed61 };
+
+	explicit CompactShares(uint64_t firstX = 1, Layout layout = Layout::Words);
+	CompactShares(const CompactShares &other, Layout layout);
+
+	uint64_t getFirstX() const;
+	Layout getLayout() const;
+	size_t size() const;
+	bool empty() const;
+	size_t getNumBytes() const;
+
+	uint64_t getY(size_t i) const;
+	void setY(size_t i, uint64_t y);
+	void push_back(uint64_t y);
+	void resize(size_t count);
+	void copyY(size_t first, size_t count, uint64_t *yValues) const;
+
+	// The y-values in place, only for the Words layout
+	uint64_t* data();
+	const uint64_t* data() const;
+
+	Share operator[](size_t i) const;
+	operator std::vector<Share>() const;
+	bool operator==(const CompactShares &other) const;
+	bool operator!=(const CompactShares &other) const;
+
+	// Yields each share as a Share pair
+	class const_iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = Share;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Share*;
+		using reference = Share;
+
+		const_iterator(const CompactShares *shares, size_t index) : shares(shares), index(index) {}
+		Share operator*() const { return (*shares)[index]; }
+		const_iterator& operator++() { index++; return *this; }
+		const_iterator operator++(int) { const_iterator old = *this; index++; return old; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+	private:
+		const CompactShares *shares;
+		size_t index;
+	};
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+private:
+	uint64_t firstX;
+	Layout layout;
+	size_t count;
+	std::vector<uint64_t> words;
+
+	static constexpr unsigned packedBits = 61;
+	static constexpr uint64_t packedMask = (1ULL << packedBits) - 1;
+
+	static size_t wordsFor(size_t count, Layout layout);
+};
+
+#endif
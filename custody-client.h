@@ -0,0 +1,47 @@
+#ifndef SHAMIRS_SECRET_SHARING_CUSTODY_CLIENT_H
+#define SHAMIRS_SECRET_SHARING_CUSTODY_CLIENT_H
+
+#include "compact-shares.h"
+#include "custody-protocol.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A blocking connection to the custody daemon.
+ *  split, recover and refresh wait for their own response. send and receive 
+ *  let several requests be in flight at once, and receive returns responses 
+ *  in whatever order the daemon finishes them.
+ */
+class CustodyClient {
+public:
+	// A response frame, with either words or an error message as its payload
+	struct Response {
+		CustodyProtocol::Header header;
+		std::vector<uint64_t> words;
+		std::string message;
+	};
+
+	explicit CustodyClient(const std::string &socketPath);
+	~CustodyClient();
+
+	CustodyClient(const CustodyClient&) = delete;
+	CustodyClient& operator=(const CustodyClient&) = delete;
+
+	std::vector<Share> split(uint64_t secret, uint64_t threshold, uint64_t numShares);
+	uint64_t recover(const std::vector<Share> &shares);
+	std::vector<Share> refresh(const std::vector<Share> &shares, uint64_t threshold);
+
+	uint32_t send(CustodyProtocol::Opcode opcode, const std::vector<uint64_t> &payload);
+	Response receive();
+
+private:
+	int fd = -1;
+	uint32_t nextId = 1;
+
+	std::vector<uint64_t> call(CustodyProtocol::Opcode opcode, const std::vector<uint64_t> &payload);
+	void readFully(void *data, size_t length);
+};
+
+#endif
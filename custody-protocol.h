@@ -0,0 +1,64 @@
+#ifndef SHAMIRS_SECRET_SHARING_CUSTODY_PROTOCOL_H
+#define SHAMIRS_SECRET_SHARING_CUSTODY_PROTOCOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * The binary protocol spoken over the custody daemon's Unix socket.
+ *  Every frame is a 16-byte header followed by length bytes of payload. 
+ *  Request payloads, and the payloads of successful responses, are 64-bit 
+ *  little-endian words. A failed response carries the error message instead. 
+ *  Responses echo the request's id, and may arrive out of order when several 
+ *  requests are in flight on one connection.
+ * 
+ *  Split    [secret, k, n]             -> [y_{1}, ..., y_{n}] at x = 1, ..., n
+ *  Recover  [x_{1}, y_{1}, ..., x_{m}, y_{m}] -> [secret]
+ *  Refresh  [k, x_{1}, y_{1}, ..., x_{m}, y_{m}] -> [y'_{1}, ..., y'_{m}]
+ */
+struct CustodyProtocol {
+	enum class Opcode : uint16_t { Split = 1, Recover = 2, Refresh = 3 };
+
+	// Mirrors the exceptions the library throws for the same request
+	enum class Status : uint16_t { Ok = 0, InvalidArgument = 1, OutOfRange = 2, UnknownOpcode = 3, Busy = 4, Internal = 5 };
+
+	struct Header {
+		uint32_t length;
+		uint32_t id;
+		uint16_t opcode;
+		uint16_t status;
+		uint32_t reserved;
+	};
+
+	// Larger requests are a protocol error and close the connection
+	static constexpr uint32_t maxPayload = 1 << 24;
+
+	// The most shares a split may ask for or a recover or refresh may carry, 
+	// and the largest threshold
+	static constexpr uint64_t maxShares = 1 << 16;
+
+
+	/**
+	 * Appends a frame to a byte buffer.
+	 * 
+	 * @param buffer The buffer to append to.
+	 * @param header The header. Its length is set from the payload.
+	 * @param payload The payload bytes.
+	 * @param length The number of payload bytes.
+	 */
+	static inline void appendFrame(std::vector<char> &buffer, Header header, const void *payload, uint32_t length) 
+	{
+		header.length = length;
+		size_t start = buffer.size();
+		buffer.resize(start + sizeof(Header) + length);
+		std::memcpy(buffer.data() + start, &header, sizeof(Header));
+		if (length > 0)
+			std::memcpy(buffer.data() + start + sizeof(Header), payload, length);
+	}
+};
+
+static_assert(sizeof(CustodyProtocol::Header) == 16, "The frame header must be packed into 16 bytes.");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Frames are copied to and from memory as little-endian words.");
+
+#endif
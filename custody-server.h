@@ -0,0 +1,107 @@
+#ifndef SHAMIRS_SECRET_SHARING_CUSTODY_SERVER_H
+#define SHAMIRS_SECRET_SHARING_CUSTODY_SERVER_H
+
+#include "bounded-queue.h"
+#include "custody-protocol.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Serves split, recover and refresh requests over a Unix domain socket.
+ *  One thread runs an epoll loop which accepts connections, parses frames 
+ *  and writes responses. Requests are handed to a pool of workers through a 
+ *  lock-free queue, and the responses come back through another. Each worker 
+ *  takes whatever has queued up as one batch and coalesces compatible 
+ *  requests: splits with the same k and n go through one BatchDealer, and 
+ *  recoveries and refreshes among the same holders share one set of Lagrange 
+ *  weights. Every worker keeps its own warm CSPRNG and recovery plans.
+ */
+class CustodyServer {
+public:
+	CustodyServer(const std::string &socketPath, unsigned numWorkers);
+	~CustodyServer();
+
+	CustodyServer(const CustodyServer&) = delete;
+	CustodyServer& operator=(const CustodyServer&) = delete;
+
+	void run();
+	void stop();
+
+	// Requests beyond this many in the queue are answered with Busy
+	static constexpr size_t queueCapacity = 1 << 14;
+
+	// The most requests a worker takes at once
+	static constexpr size_t maxBatch = 256;
+
+	// A connection's requests stop being read while more replies than this are unsent
+	static constexpr size_t maxPendingOutput = 1 << 24;
+
+private:
+	struct Job {
+		uint64_t connection;
+		CustodyProtocol::Header header;
+		std::vector<uint64_t> payload;
+	};
+
+	struct Reply {
+		uint64_t connection;
+		std::vector<char> bytes;
+	};
+
+	struct Connection {
+		int fd;
+		std::vector<char> input;
+		std::vector<char> output;
+		size_t outputSent = 0;
+		bool waitingToWrite = false;
+
+		// The events epoll currently reports, EPOLLIN and EPOLLOUT
+		uint32_t events = 0;
+	};
+
+	class Worker;
+
+	std::string socketPath;
+	bool bound = false;
+	int listenFd = -1;
+	int epollFd = -1;
+
+	// Written by the workers when replies are queued, and by stop()
+	int replyFd = -1;
+	int stopFd = -1;
+
+	BoundedQueue<Job> jobs;
+	BoundedQueue<Reply> replies;
+
+	// Workers sleep on the condition variable only once the queue is empty
+	std::atomic<size_t> pendingJobs{0};
+	std::atomic<unsigned> sleepingWorkers{0};
+	std::atomic<bool> stopping{false};
+	std::mutex sleepMutex;
+	std::condition_variable wakeWorkers;
+	std::vector<std::thread> workers;
+
+	// By serial number rather than fd, so a late reply can't reach a reused fd
+	std::unordered_map<uint64_t, Connection> connections;
+	uint64_t nextConnection;
+
+	void release();
+	void acceptConnections();
+	void readConnection(uint64_t serial);
+	void flushConnection(uint64_t serial);
+	void watchConnection(uint64_t serial, Connection &connection);
+	void closeConnection(uint64_t serial);
+	void deliverReplies();
+	void workerLoop();
+	bool waitForJobs();
+	void postReply(Reply &reply);
+};
+
+#endif
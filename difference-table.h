@@ -0,0 +1,27 @@
+#ifndef SHAMIRS_SECRET_SHARING_DIFFERENCE_TABLE_H
+#define SHAMIRS_SECRET_SHARING_DIFFERENCE_TABLE_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Tabulates a degree d polynomial over consecutive x-values using forward 
+ * differences. Once set up from d+1 consecutive values, every following 
+ * value costs d field additions and no multiplications.
+ */
+class DifferenceTable {
+public:
+	DifferenceTable() = default;
+	DifferenceTable(uint64_t firstX, const std::vector<uint64_t> &values);
+
+	bool isEmpty() const;
+	uint64_t getNextX() const;
+	uint64_t next();
+
+private:
+	// differences[i] is the i-th forward difference at nextX, so differences[0] = P(nextX)
+	std::vector<uint64_t> differences;
+	uint64_t nextX = 0;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SHAMIRS_SECRET_SHARING_FP127_H
+#define SHAMIRS_SECRET_SHARING_FP127_H
+
+#include <cstdint>
+
+/**
+ * Arithmetic in the prime field Fp where p = 2^127 - 1, for 127-bit secrets.
+ *  Like Fp61, p is a Mersenne prime, so 2^127 = 1 (mod p) and a 256-bit
+ *  product is reduced by adding its top half onto its bottom 127 bits.
+ *  Values are held in unsigned __int128 and every function expects (and
+ *  returns) canonical values in [0, p).
+ */
+struct Fp127 {
+	using Element = __uint128_t;
+
+	// The 12th Mersenne Prime, 2^127 - 1
+	static constexpr Element p = (Element(1) << 127) - 1;
+
+	// Random words needed per candidate element
+	static constexpr unsigned randomWords = 2;
+
+
+	/**
+	 * Maps a value in [0, 2p) to [0, p) without branching.
+	 *  If a-p underflows, its top bit is set and the mask adds p back.
+	 */
+	static inline Element finalize(Element a)
+	{
+		Element t = a - p;
+		return t + (p & (0 - (t >> 127)));
+	}
+
+
+	/**
+	 * Computes a+b (mod p).
+	 */
+	static inline Element add(Element a, Element b)
+	{
+		return finalize(a + b);
+	}
+
+
+	/**
+	 * Computes a-b (mod p). The +p is required in case a-b is negative.
+	 */
+	static inline Element sub(Element a, Element b)
+	{
+		return finalize(a + p - b);
+	}
+
+
+	/**
+	 * Computes a*b (mod p).
+	 *  The 254-bit product is built from four 64x64 -> 128-bit multiplies as
+	 *  hi*2^128 + lo. Folding at bit 127 gives (lo mod 2^127) + (hi*2 + lo/2^127),
+	 *  which fits in 128 bits, and a second fold leaves a value below 2p.
+	 */
+	static inline Element mul(Element a, Element b)
+	{
+		uint64_t a0 = static_cast<uint64_t>(a), a1 = static_cast<uint64_t>(a >> 64);
+		uint64_t b0 = static_cast<uint64_t>(b), b1 = static_cast<uint64_t>(b >> 64);
+
+		// a1 and b1 are below 2^63, so the middle terms can't overflow when added
+		Element low = Element(a0) * b0;
+		Element middle = Element(a0) * b1 + Element(a1) * b0;
+		Element high = Element(a1) * b1;
+
+		Element lo = low + (middle << 64);
+		Element hi = high + (middle >> 64) + (lo < low);
+
+		Element folded = (lo & p) + ((hi << 1) | (lo >> 127));
+		return finalize((folded & p) + (folded >> 127));
+	}
+
+
+	/**
+	 * Computes base^exp (mod p) by successive squaring.
+	 */
+	static inline Element pow(Element base, Element exp)
+	{
+		Element res = 1;
+
+		for (; exp > 0; exp >>= 1)
+		{
+			if (exp & 1)
+				res = mul(res, base);
+			base = mul(base, base);
+		}
+
+		return res;
+	}
+
+
+	/**
+	 * Computes a^{-1} (mod p) with Fermat's Little Theorem, a^{-1} = a^{p-2}.
+	 *  The caller is responsible for ensuring a != 0.
+	 */
+	static inline Element inv(Element a)
+	{
+		return pow(a, p-2);
+	}
+
+
+	/**
+	 * Canonical values are already in the representation used for arithmetic.
+	 */
+	static inline Element encode(Element a)
+	{
+		return a;
+	}
+
+	static inline Element decode(Element a)
+	{
+		return a;
+	}
+
+
+	/**
+	 * Turns two random words into a uniform element by masking to 127 bits.
+	 *
+	 * @param words randomWords uniformly random words.
+	 * @param value Set to the element, if the candidate wasn't rejected.
+	 *
+	 * @return False if the candidate was p and more words are needed.
+	 */
+	static inline bool fromRandomWords(const uint64_t *words, Element &value)
+	{
+		value = ((Element(words[1]) << 64) | words[0]) & p;
+		return value != p;
+	}
+};
+
+#endif
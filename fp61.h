@@ -0,0 +1,248 @@
+#ifndef SHAMIRS_SECRET_SHARING_FP61_H
+#define SHAMIRS_SECRET_SHARING_FP61_H
+
+#include "stats.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Arithmetic in the prime field Fp where p = 2^61 - 1.
+ *  Because p is a Mersenne prime, 2^61 = 1 (mod p), so the bits above bit 61
+ *  can be folded back onto the low bits with a shift and an add instead of
+ *  a division. Every function expects (and returns) canonical values in [0, p)
+ *  unless stated otherwise.
+ */
+struct Fp61 {
+	using Element = uint64_t;
+
+	// The 8th Mersenne Prime, 2^61 - 1
+	static constexpr uint64_t p = (1ULL << 61) - 1;
+
+	// Random words needed per candidate element
+	static constexpr unsigned randomWords = 1;
+
+
+	/**
+	 * Maps a value in [0, 2p) to [0, p) without branching.
+	 *  If a-p underflows, its top bit is set and the mask adds p back.
+	 *
+	 * @param a A value less than 2p.
+	 *
+	 * @return a (mod p)
+	 */
+	static inline uint64_t finalize(uint64_t a)
+	{
+		uint64_t t = a - p;
+		return t + (p & (0 - (t >> 63)));
+	}
+
+
+	/**
+	 * Computes a (mod p) for any 64-bit value by folding the top 3 bits.
+	 *
+	 * @param a
+	 *
+	 * @return a (mod p)
+	 */
+	static inline uint64_t reduce(uint64_t a)
+	{
+		return finalize((a & p) + (a >> 61));
+	}
+
+
+	/**
+	 * Computes a (mod p) for any 128-bit value.
+	 *  a = hi*2^61 + lo = hi + lo (mod p), and hi is folded a second time
+	 *  because it can be up to 67 bits wide.
+	 *
+	 * @param a
+	 *
+	 * @return a (mod p)
+	 */
+	static inline uint64_t reduce(__uint128_t a)
+	{
+		uint64_t lo = static_cast<uint64_t>(a) & p;
+		__uint128_t hi = a >> 61;
+		uint64_t folded = lo + (static_cast<uint64_t>(hi) & p) + static_cast<uint64_t>(hi >> 61);
+		return reduce(folded);
+	}
+
+
+	/**
+	 * Computes a+b (mod p).
+	 */
+	static inline uint64_t add(uint64_t a, uint64_t b)
+	{
+		return finalize(a + b);
+	}
+
+
+	/**
+	 * Computes a-b (mod p). The +p is required in case a-b is negative.
+	 */
+	static inline uint64_t sub(uint64_t a, uint64_t b)
+	{
+		return finalize(a + p - b);
+	}
+
+
+	/**
+	 * Computes -a (mod p).
+	 */
+	static inline uint64_t neg(uint64_t a)
+	{
+		return finalize(p - a);
+	}
+
+
+	/**
+	 * Computes a*b (mod p).
+	 *  The product is below 2^122, so a single fold leaves a value below 2p.
+	 */
+	static inline uint64_t mul(uint64_t a, uint64_t b)
+	{
+		SSS_STATS_COUNT(Multiplications, 1);
+		__uint128_t t = __uint128_t(a) * b;
+		uint64_t lo = static_cast<uint64_t>(t) & p;
+		uint64_t hi = static_cast<uint64_t>(t >> 61);
+		return finalize(lo + hi);
+	}
+
+
+	/**
+	 * Computes base^exp (mod p) by successive squaring.
+	 *
+	 * @param base The base.
+	 * @param exp The exponent.
+	 *
+	 * @return base^exp (mod p)
+	 */
+	static inline uint64_t pow(uint64_t base, uint64_t exp)
+	{
+		SSS_STATS_COUNT(Exponentiations, 1);
+		uint64_t res = 1;
+
+		for (; exp > 0; exp >>= 1)
+		{
+			if (exp & 1)
+				res = mul(res, base);
+			base = mul(base, base);
+		}
+
+		return res;
+	}
+
+
+	/**
+	 * Computes a^{-1} (mod p) with Fermat's Little Theorem, a^{-1} = a^{p-2}.
+	 *  The caller is responsible for ensuring a != 0.
+	 */
+	static inline uint64_t inv(uint64_t a)
+	{
+		SSS_STATS_COUNT(Inversions, 1);
+		SSS_STATS_TIMER(Inversion);
+		return pow(a, p-2);
+	}
+
+
+	/**
+	 * Canonical values are already in the representation used for arithmetic.
+	 */
+	static inline uint64_t encode(uint64_t a)
+	{
+		return a;
+	}
+
+	static inline uint64_t decode(uint64_t a)
+	{
+		return a;
+	}
+
+
+	/**
+	 * Turns a random word into a uniform element by masking to 61 bits.
+	 *
+	 * @param words randomWords uniformly random words.
+	 * @param value Set to the element, if the candidate wasn't rejected.
+	 *
+	 * @return False if the candidate was p and more words are needed.
+	 */
+	static inline bool fromRandomWords(const uint64_t *words, uint64_t &value)
+	{
+		value = words[0] & p;
+		return value != p;
+	}
+
+
+	/**
+	 * Replaces every value with its inverse using a single exponentiation.
+	 *  Prefix products a_{1}, a_{1}a_{2}, ..., a_{1}...a_{k} are inverted once,
+	 *  then walked backwards: a_{i}^{-1} = (a_{1}...a_{i})^{-1} * (a_{1}...a_{i-1}).
+	 *  This costs 3(k-1) multiplications plus one inversion instead of k inversions.
+	 *
+	 * @param values The values to invert in place. None may be 0.
+	 */
+	static inline void batchInv(std::vector<uint64_t> &values)
+	{
+		if (values.empty())
+			return;
+		SSS_STATS_COUNT(BatchInversions, 1);
+
+		std::vector<uint64_t> prefix(values.size());
+		uint64_t running = 1;
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			prefix[i] = running;
+			running = mul(running, values[i]);
+		}
+
+		if (running == 0)
+			throw std::invalid_argument("Error: 0 has no multiplicative inverse.");
+
+		// running^{-1} = (a_{1}...a_{k})^{-1}
+		uint64_t inverse = inv(running);
+		for (size_t i = values.size(); i-- > 0;)
+		{
+			uint64_t value = values[i];
+			values[i] = mul(inverse, prefix[i]);
+			inverse = mul(inverse, value);
+		}
+	}
+
+
+	/**
+	 * Accumulates a sum of field elements and products with lazy reduction.
+	 *  Products are added to a 128-bit total and only reduced once every 64
+	 *  terms, since 64 products of values below 2^61 cannot overflow 2^128.
+	 */
+	class Accumulator {
+	public:
+		inline void add(uint64_t a)
+		{
+			addProduct(a, 1);
+		}
+
+		inline void addProduct(uint64_t a, uint64_t b)
+		{
+			total += __uint128_t(a) * b;
+			if (++pending == 64)
+			{
+				total = Fp61::reduce(total);
+				pending = 0;
+			}
+		}
+
+		inline uint64_t value() const
+		{
+			return Fp61::reduce(total);
+		}
+
+	private:
+		__uint128_t total = 0;
+		unsigned pending = 0;
+	};
+};
+
+#endif
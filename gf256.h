@@ -0,0 +1,58 @@
+#ifndef SHAMIRS_SECRET_SHARING_GF256_H
+#define SHAMIRS_SECRET_SHARING_GF256_H
+
+#include "random-source.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A share of a byte secret: one y-byte per secret byte, all at the same x
+struct ByteShare {
+	uint8_t x;
+	std::vector<uint8_t> y;
+};
+
+/**
+ * Shamir's Secret Sharing over GF(2^8), byte by byte.
+ *  Every byte of the secret gets its own degree k-1 polynomial, and all of 
+ *  them are evaluated at the same x-values, so each share is exactly as long 
+ *  as the secret. There can be at most 255 shares.
+ */
+class GF256SecretSharing {
+public:
+	GF256SecretSharing(const std::vector<uint8_t> &secret, uint64_t threshold, 
+		std::shared_ptr<RandomSource> randomSource = nullptr);
+
+	uint64_t getNumShares() const;
+	uint64_t getThreshold() const;
+	void generateAdditionalShares(uint64_t numToGenerate);
+	const std::vector<ByteShare>& getShares() const;
+
+	// Static because combining the shares is independent of state
+	static std::vector<uint8_t> recoverSecret(const std::vector<ByteShare> &userShares);
+
+	// The bulk multiplication kernels, selected at runtime for this CPU
+	enum class Kernel { Scalar, SSSE3, AVX2 };
+	static Kernel getKernel();
+	static bool setKernel(Kernel kernel);
+
+	static uint8_t multiply(uint8_t a, uint8_t b);
+	static uint8_t getMultiplicativeInverse(uint8_t a);
+
+private:
+	uint64_t threshold;
+
+	// A ChaCha20 CSPRNG unless another source was given
+	std::shared_ptr<RandomSource> randomSource;
+
+	// threshold rows of secret-length coefficients, row 0 holds the secret
+	std::vector<std::vector<uint8_t>> coefficients;
+	std::vector<ByteShare> shares;
+
+	void generateCoefficients(const std::vector<uint8_t> &secret);
+	std::vector<uint8_t> evaluatePolynomials(uint8_t x) const;
+};
+
+#endif
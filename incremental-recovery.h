@@ -0,0 +1,49 @@
+#ifndef SHAMIRS_SECRET_SHARING_INCREMENTAL_RECOVERY_H
+#define SHAMIRS_SECRET_SHARING_INCREMENTAL_RECOVERY_H
+
+#include "compact-shares.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Recovers a secret from shares that arrive one at a time.
+ *  The Lagrange weight of share i at 0 is x_{1}...x_{m} / (x_{i} * d_{i}), where
+ *  d_{i} = prod_{j != i} (x_{j} - x_{i}) only depends on the x-values. Each d_{i}
+ *  is kept up to date as shares come and go, so adding a share costs O(k)
+ *  multiplications and removing one O(k) plus one inversion. Once k shares
+ *  are in, the secret takes O(k) and a single batch inversion, instead of
+ *  the O(k^2) that recoverSecret does after the last share.
+ */
+class IncrementalRecovery {
+public:
+	explicit IncrementalRecovery(uint64_t threshold);
+
+	uint64_t getThreshold() const;
+	size_t getNumShares() const;
+	bool isComplete() const;
+
+	bool addShare(const Share &share);
+	bool removeShare(uint64_t x);
+	uint64_t getSecret() const;
+
+private:
+	uint64_t threshold;
+
+	// The shares in arrival order, with holes filled by the last share on removal
+	std::vector<uint64_t> xValues;
+	std::vector<uint64_t> yValues;
+
+	// d_{i} = prod_{j != i} (x_{j} - x_{i}) for each share
+	std::vector<uint64_t> denominators;
+
+	// x_{1}...x_{m}, the numerator shared by every weight
+	uint64_t numerator = 1;
+
+	// The index of each x-value, for rejecting duplicates and finding removals
+	std::unordered_map<uint64_t, size_t> indices;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef SHAMIRS_SECRET_SHARING_MONTGOMERY_FIELD_H
+#define SHAMIRS_SECRET_SHARING_MONTGOMERY_FIELD_H
+
+#include <cstdint>
+
+/**
+ * Arithmetic in the prime field Fp for any odd prime P below 2^63.
+ *  Without a special form for p, reduction uses Montgomery's method with
+ *  R = 2^64: elements are stored as aR (mod P), and a product abR^2 is
+ *  brought back to abR with two multiplications and a shift instead of a
+ *  division. The constants are computed at compile time for each P.
+ *  P being prime is the caller's responsibility; inverses are wrong otherwise.
+ *
+ * @tparam P The modulus, an odd prime in (2, 2^63).
+ */
+template <uint64_t P>
+struct MontgomeryField {
+	static_assert(P > 2 && P % 2 == 1, "Montgomery reduction needs an odd modulus.");
+	static_assert(P < (1ULL << 63), "The modulus must be below 2^63 so sums can't overflow.");
+
+	using Element = uint64_t;
+
+	static constexpr Element p = P;
+
+	// Random words needed per candidate element
+	static constexpr unsigned randomWords = 1;
+
+
+	/**
+	 * Computes -P^{-1} (mod 2^64) with Newton's iteration, each step doubling
+	 * the number of correct low bits. P is its own inverse mod 8.
+	 */
+	static constexpr uint64_t negativeInverse()
+	{
+		uint64_t inverse = P;
+		for (int i = 0; i < 5; i++)
+			inverse *= 2 - P * inverse;
+		return 0 - inverse;
+	}
+
+	// -P^{-1} (mod 2^64), R^2 (mod P) for encoding, and 1 in Montgomery form
+	static constexpr uint64_t pNegInv = negativeInverse();
+	static constexpr uint64_t r2 = static_cast<uint64_t>(((__uint128_t(1) << 64) % P) * ((__uint128_t(1) << 64) % P) % P);
+	static constexpr uint64_t one = static_cast<uint64_t>((__uint128_t(1) << 64) % P);
+
+	// The mask rejection sampling draws candidates with
+	static constexpr uint64_t sampleMask()
+	{
+		uint64_t mask = P;
+		for (int shift = 1; shift < 64; shift <<= 1)
+			mask |= mask >> shift;
+		return mask;
+	}
+
+
+	/**
+	 * Montgomery reduction: computes tR^{-1} (mod P) for t < P*2^64.
+	 *  m is chosen so t + mP is divisible by 2^64, and (t + mP)/2^64 < 2P.
+	 */
+	static inline Element redc(__uint128_t t)
+	{
+		uint64_t m = static_cast<uint64_t>(t) * pNegInv;
+		uint64_t u = static_cast<uint64_t>((t + __uint128_t(m) * P) >> 64);
+		return u >= P ? u - P : u;
+	}
+
+
+	/**
+	 * Computes a+b (mod P). Montgomery form is linear, so sums need no conversion.
+	 */
+	static inline Element add(Element a, Element b)
+	{
+		uint64_t t = a + b;
+		return t >= P ? t - P : t;
+	}
+
+
+	/**
+	 * Computes a-b (mod P).
+	 */
+	static inline Element sub(Element a, Element b)
+	{
+		return a >= b ? a - b : a + P - b;
+	}
+
+
+	/**
+	 * Computes a*b (mod P) in Montgomery form: (aR)(bR)R^{-1} = abR.
+	 */
+	static inline Element mul(Element a, Element b)
+	{
+		return redc(__uint128_t(a) * b);
+	}
+
+
+	/**
+	 * Computes base^exp (mod P) by successive squaring, with base in Montgomery form.
+	 */
+	static inline Element pow(Element base, uint64_t exp)
+	{
+		Element res = one;
+
+		for (; exp > 0; exp >>= 1)
+		{
+			if (exp & 1)
+				res = mul(res, base);
+			base = mul(base, base);
+		}
+
+		return res;
+	}
+
+
+	/**
+	 * Computes a^{-1} (mod P) with Fermat's Little Theorem, a^{-1} = a^{P-2}.
+	 *  The caller is responsible for ensuring a != 0.
+	 */
+	static inline Element inv(Element a)
+	{
+		return pow(a, P-2);
+	}
+
+
+	/**
+	 * Converts a canonical value in [0, P) to Montgomery form, aR (mod P).
+	 */
+	static inline Element encode(uint64_t a)
+	{
+		return mul(a, r2);
+	}
+
+
+	/**
+	 * Converts from Montgomery form back to a canonical value in [0, P).
+	 */
+	static inline uint64_t decode(Element a)
+	{
+		return redc(a);
+	}
+
+
+	/**
+	 * Turns a random word into a uniform element by masking to P's bit length.
+	 *
+	 * @param words randomWords uniformly random words.
+	 * @param value Set to the element, if the candidate wasn't rejected.
+	 *
+	 * @return False if the candidate was P or more, and more words are needed.
+	 */
+	static inline bool fromRandomWords(const uint64_t *words, Element &value)
+	{
+		uint64_t candidate = words[0] & sampleMask();
+		if (candidate >= P)
+			return false;
+
+		value = encode(candidate);
+		return true;
+	}
+};
+
+#endif
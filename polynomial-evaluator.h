@@ -0,0 +1,29 @@
+#ifndef SHAMIRS_SECRET_SHARING_POLYNOMIAL_EVALUATOR_H
+#define SHAMIRS_SECRET_SHARING_POLYNOMIAL_EVALUATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Evaluates a polynomial over Fp61 at many x-values at once with Horner's 
+ * scheme. Several x-values are carried through the coefficients together, 
+ * in SIMD lanes where the CPU has them, so their multiplications overlap.
+ * The same kernels multiply out the differences used as Lagrange denominators.
+ */
+class PolynomialEvaluator {
+public:
+	// P(x) = coefficients[0] + coefficients[1]x + ... + coefficients[n-1]x^{n-1}
+	static void evaluate(const uint64_t *coefficients, size_t numCoefficients, 
+		const uint64_t *xValues, uint64_t *yValues, size_t count);
+
+	// products[i] = (points[i] - roots[0])...(points[i] - roots[n-1]), with zero factors skipped
+	static void productsOfDifferences(const uint64_t *roots, size_t numRoots, 
+		const uint64_t *points, uint64_t *products, size_t count);
+
+	// The multi-lane kernels, selected at runtime for this CPU
+	enum class Kernel { Scalar, AVX2, AVX512 };
+	static Kernel getKernel();
+	static bool setKernel(Kernel kernel);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef SHAMIRS_SECRET_SHARING_POLYNOMIAL_H
+#define SHAMIRS_SECRET_SHARING_POLYNOMIAL_H
+
+#include "thread-pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Dense polynomial arithmetic over Fp61, for the asymptotically fast paths.
+ *  A polynomial is a vector of coefficients with the constant term first.
+ *  Results are trimmed so the last coefficient is non-zero, and the zero
+ *  polynomial is the empty vector. The functions taking a ThreadPool split 
+ *  large products and subproduct trees across it, and run serially without one.
+ */
+class Polynomial {
+public:
+	using Coefficients = std::vector<uint64_t>;
+
+	static Coefficients multiply(const Coefficients &a, const Coefficients &b, ThreadPool *pool = nullptr);
+	static Coefficients inverseSeries(const Coefficients &f, size_t n, ThreadPool *pool = nullptr);
+	static void divide(const Coefficients &a, const Coefficients &b, Coefficients &quotient, Coefficients &remainder, 
+		ThreadPool *pool = nullptr);
+	static Coefficients remainder(const Coefficients &a, const Coefficients &b, ThreadPool *pool = nullptr);
+	static Coefficients derivative(const Coefficients &f);
+	static uint64_t evaluate(const Coefficients &f, uint64_t x);
+
+	// (x - x_{1})...(x - x_{k}), and the values of f at x_{1}, ..., x_{k}
+	static Coefficients fromRoots(const std::vector<uint64_t> &roots);
+	static std::vector<uint64_t> evaluateMany(const Coefficients &f, const std::vector<uint64_t> &xValues);
+
+	// M'(x_{i}) = (x_{i} - x_{1})...(x_{i} - x_{k}) without j=i, where M = fromRoots(roots)
+	static std::vector<uint64_t> derivativeAtRoots(const std::vector<uint64_t> &roots, ThreadPool *pool = nullptr);
+
+	// The polynomial of degree < k through (x_{1}, y_{1}), ..., (x_{k}, y_{k})
+	static Coefficients interpolate(const std::vector<uint64_t> &xValues, const std::vector<uint64_t> &yValues);
+
+	// Below this size multiplication is done directly instead of with Karatsuba
+	static constexpr size_t karatsubaThreshold = 32;
+
+	// Below this size a product isn't worth splitting across threads
+	static constexpr size_t parallelThreshold = 1 << 11;
+
+private:
+	static void trim(Coefficients &f);
+	static void multiplyKaratsuba(const uint64_t *a, const uint64_t *b, size_t n, uint64_t *result);
+
+	// level 0 holds the leaves x - x_{i}, each level above multiplies pairs
+	using SubproductTree = std::vector<std::vector<Coefficients>>;
+	static SubproductTree buildSubproductTree(const std::vector<uint64_t> &roots, ThreadPool *pool = nullptr);
+	static void evaluateDown(const SubproductTree &tree, size_t level, size_t index, 
+		const Coefficients &f, const std::vector<uint64_t> &xValues, std::vector<uint64_t> &values);
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef SHAMIRS_SECRET_SHARING_RANDOM_SOURCE_H
+#define SHAMIRS_SECRET_SHARING_RANDOM_SOURCE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * A source of uniformly random 64-bit words, drawn from in bulk.
+ *  It also meets the UniformRandomBitGenerator requirements, so it can be 
+ *  used with the standard distributions.
+ */
+class RandomSource {
+public:
+	virtual ~RandomSource() = default;
+	virtual void fill(uint64_t *words, size_t count) = 0;
+
+	// Uniform field elements in [min, p), for a small min such as 0 or 1
+	void fillFieldElements(uint64_t *values, size_t count, uint64_t min = 0);
+
+	using result_type = uint64_t;
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return ~result_type(0); }
+	result_type operator()();
+};
+
+
+/**
+ * The ChaCha20 stream cipher as a CSPRNG, keyed from the kernel with getrandom.
+ *  The 256-bit key, a 64-bit block counter and a 64-bit nonce make up the 
+ *  state (the original layout, not RFC 8439's 32-bit counter). The keystream 
+ *  is produced many 64-byte blocks at a time by AVX2 or AVX-512 kernels 
+ *  picked at runtime. fill() can be called from several threads.
+ */
+class ChaCha20Rng : public RandomSource {
+public:
+	ChaCha20Rng();
+	ChaCha20Rng(const std::array<uint32_t, 8> &key, uint64_t nonce, uint64_t counter = 0);
+	~ChaCha20Rng();
+
+	ChaCha20Rng(const ChaCha20Rng&) = delete;
+	ChaCha20Rng& operator=(const ChaCha20Rng&) = delete;
+
+	void fill(uint64_t *words, size_t count) override;
+
+	// The multi-block kernels, selected at runtime for this CPU
+	enum class Kernel { Scalar, AVX2, AVX512 };
+	static Kernel getKernel();
+	static bool setKernel(Kernel kernel);
+
+	// The number of blocks generated at once for small requests
+	static constexpr size_t bufferBlocks = 16;
+
+private:
+	std::mutex mutex;
+
+	// The constants, key, counter and nonce, as 16 little-endian words
+	std::array<uint32_t, 16> state;
+
+	// Unused keystream, from buffer[bufferUsed] on
+	std::array<uint64_t, bufferBlocks * 8> buffer;
+	size_t bufferUsed = bufferBlocks * 8;
+
+	void setKey(const std::array<uint32_t, 8> &key, uint64_t nonce, uint64_t counter);
+	void generate(uint64_t *words, size_t numBlocks);
+};
+
+#endif
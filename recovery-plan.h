@@ -0,0 +1,76 @@
+#ifndef SHAMIRS_SECRET_SHARING_RECOVERY_PLAN_H
+#define SHAMIRS_SECRET_SHARING_RECOVERY_PLAN_H
+
+#include "thread-pool.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * The Lagrange weights at x=0 for a fixed set of x-values.
+ *  Building a plan costs O(k^2), but afterwards any secret shared among the 
+ *  same holders is recovered with a k-term dot product.
+ */
+class RecoveryPlan {
+public:
+	explicit RecoveryPlan(const std::vector<uint64_t> &xValues, ThreadPool *pool = nullptr);
+
+	size_t size() const;
+	const std::vector<uint64_t>& getXValues() const;
+	const std::vector<uint64_t>& getWeights() const;
+
+	// The y-values must be in the same order as getXValues()
+	uint64_t recover(const std::vector<uint64_t> &yValues, ThreadPool *pool = nullptr) const;
+	uint64_t recover(const uint64_t *yValues, ThreadPool *pool = nullptr) const;
+
+	// Below this many shares the dot product isn't split between threads
+	static constexpr size_t parallelThreshold = 1 << 15;
+
+private:
+	std::vector<uint64_t> xValues;
+	std::vector<uint64_t> weights;
+};
+
+
+/**
+ * A thread-safe least-recently-used cache of recovery plans, keyed by the 
+ * sorted x-values. It holds at most capacity plans and maxShares shares 
+ * between them; a plan larger than maxShares is built but not kept.
+ */
+class RecoveryPlanCache {
+public:
+	// A plan costs 16 bytes per share, so 2^20 shares is 16 MiB
+	static constexpr size_t defaultMaxShares = 1 << 20;
+
+	explicit RecoveryPlanCache(size_t capacity, size_t maxShares = defaultMaxShares);
+
+	std::shared_ptr<const RecoveryPlan> get(const std::vector<uint64_t> &sortedXValues, ThreadPool *pool = nullptr);
+	size_t size() const;
+	void clear();
+
+	// The cache used by ShamirsSecretSharing::recoverSecret
+	static RecoveryPlanCache& global();
+
+private:
+	using Entry = std::shared_ptr<const RecoveryPlan>;
+
+	// Orders the index by the x-values pointed to, so the key isn't a second copy
+	struct XValuesLess {
+		bool operator()(const std::vector<uint64_t> *a, const std::vector<uint64_t> *b) const { return *a < *b; }
+	};
+
+	size_t capacity;
+	size_t maxShares;
+	size_t numShares = 0;
+	mutable std::mutex mutex;
+
+	// Most recently used at the front, indexed by each plan's own getXValues()
+	std::list<Entry> entries;
+	std::map<const std::vector<uint64_t>*, std::list<Entry>::iterator, XValuesLess> index;
+};
+
+#endif
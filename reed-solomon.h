@@ -0,0 +1,21 @@
+#ifndef SHAMIRS_SECRET_SHARING_REED_SOLOMON_H
+#define SHAMIRS_SECRET_SHARING_REED_SOLOMON_H
+
+#include "polynomial.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Reed-Solomon decoding over Fp61. The shares of a secret are a Reed-Solomon 
+ * codeword: the values of a polynomial of degree < k at n distinct points, 
+ * so up to (n-k)/2 wrong values can be found and corrected.
+ */
+class ReedSolomon {
+public:
+	static bool decode(const std::vector<uint64_t> &xValues, const std::vector<uint64_t> &yValues, 
+		size_t k, Polynomial::Coefficients &message, std::vector<size_t> &errorPositions);
+};
+
+#endif
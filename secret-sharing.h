@@ -0,0 +1,264 @@
+#ifndef SHAMIRS_SECRET_SHARING_TEMPLATE_H
+#define SHAMIRS_SECRET_SHARING_TEMPLATE_H
+
+#include "fp127.h"
+#include "fp61.h"
+#include "montgomery-field.h"
+#include "random-source.h"
+#include "shamir.h"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * Shamir's Secret Sharing over the prime field chosen at compile time.
+ *  Field is a policy struct of static functions, like Fp61, Fp127 or
+ *  MontgomeryField<P>, providing:
+ *   Element, p and randomWords,
+ *   add, sub, mul and inv on elements in its own representation,
+ *   encode and decode between canonical values in [0, p) and that representation,
+ *   fromRandomWords, turning randomWords random words into an element or rejecting them.
+ *  Every call is resolved at compile time and inlined, so each field gets
+ *  its own reduction with no runtime dispatch. Secrets and shares are
+ *  always canonical values.
+ *
+ *  Shares are at x = 1, 2, ..., n and generated with Horner's method, and
+ *  recovery takes O(k^2) multiplications and one inversion.
+ *  SecretSharing<Fp61> is specialized to use ShamirsSecretSharing instead.
+ *
+ * @tparam Field The field policy.
+ */
+template <typename Field>
+class SecretSharing {
+public:
+	using Element = typename Field::Element;
+	using Share = std::pair<Element, Element>;
+
+	/**
+	 * Hides the secret in a random degree k-1 polynomial.
+	 *  The coefficients come from randomSource, or a new ChaCha20Rng if it's null.
+	 */
+	SecretSharing(Element secret, uint64_t threshold, std::shared_ptr<RandomSource> randomSource = nullptr)
+	: threshold(threshold), randomSource(std::move(randomSource))
+	{
+		if (secret > Field::p-1)
+			throw std::domain_error("Error: The secret is too large.");
+		if (threshold < 2 || threshold > Field::p-1)
+			throw std::domain_error("Error: The threshold (k) is outside the range.");
+
+		if (!this->randomSource)
+			this->randomSource = std::make_shared<ChaCha20Rng>();
+
+		// secret, a_{1}, ..., a_{k-1}, with a non-zero leading coefficient
+		this->coefficients.resize(threshold);
+		this->coefficients[0] = Field::encode(secret);
+		fillRandomElements(this->coefficients.data() + 1, threshold - 2, false);
+		fillRandomElements(this->coefficients.data() + threshold - 1, 1, true);
+	}
+
+	uint64_t getNumShares() const
+	{
+		return this->shares.size();
+	}
+
+	uint64_t getThreshold() const
+	{
+		return this->threshold;
+	}
+
+	const std::vector<Share>& getShares() const
+	{
+		return this->shares;
+	}
+
+
+	/**
+	 * Generates n additional shares, continuing from x = getNumShares()+1.
+	 *
+	 * @param numToGenerate The number of new shares to create.
+	 */
+	void generateAdditionalShares(uint64_t numToGenerate)
+	{
+		uint64_t prevSize = this->shares.size();
+		if (numToGenerate > Field::p-1-prevSize)
+			throw std::domain_error("Error: The number of shares requested is outside the range.");
+
+		this->shares.reserve(prevSize + numToGenerate);
+		for (uint64_t x = prevSize + 1; x <= prevSize + numToGenerate; x++)
+		{
+			Element encodedX = Field::encode(x);
+
+			Element y = this->coefficients.back();
+			for (size_t i = this->coefficients.size() - 1; i-- > 0;)
+				y = Field::add(Field::mul(y, encodedX), this->coefficients[i]);
+
+			this->shares.push_back({x, Field::decode(y)});
+		}
+	}
+
+
+	/**
+	 * Recovers the secret with Lagrange interpolation at 0.
+	 *  The weight of share i is x_{1}...x_{k} / (x_{i} * prod_{j != i} (x_{j} - x_{i})),
+	 *  so the k denominators are inverted together and the numerator is
+	 *  multiplied in once, after the sum.
+	 *
+	 * @param userShares k or more distinct shares.
+	 *
+	 * @return The secret.
+	 */
+	static Element recoverSecret(const std::vector<Share> &userShares)
+	{
+		if (userShares.empty())
+			throw std::invalid_argument("Error: No shares were provided to recover the secret from.");
+
+		for (const auto &[xi, yi] : userShares)
+		{
+			if (xi < 1 || xi > Field::p-1 || yi > Field::p-1)
+				throw std::domain_error("Error: A provided share is outside the field range.");
+		}
+
+		size_t k = userShares.size();
+		std::vector<Element> xValues(k), denominators(k);
+		for (size_t i = 0; i < k; i++)
+			xValues[i] = Field::encode(userShares[i].first);
+
+		Element numerator = Field::encode(1);
+		for (size_t i = 0; i < k; i++)
+		{
+			numerator = Field::mul(numerator, xValues[i]);
+
+			Element denominator = xValues[i];
+			for (size_t j = 0; j < k; j++)
+			{
+				if (j != i)
+					denominator = Field::mul(denominator, Field::sub(xValues[j], xValues[i]));
+			}
+			denominators[i] = denominator;
+		}
+
+		invertAll(denominators);
+
+		Element sum = Field::encode(0);
+		for (size_t i = 0; i < k; i++)
+			sum = Field::add(sum, Field::mul(Field::encode(userShares[i].second), denominators[i]));
+
+		return Field::decode(Field::mul(numerator, sum));
+	}
+
+private:
+	uint64_t threshold;
+
+	// A ChaCha20 CSPRNG unless another source was given
+	std::shared_ptr<RandomSource> randomSource;
+
+	// secret, a_{1}, ..., a_{k-1}, in the field's representation
+	std::vector<Element> coefficients;
+	std::vector<Share> shares;
+
+
+	/**
+	 * Draws uniform elements, redrawing the candidates the field rejects.
+	 *
+	 * @param values The elements to set.
+	 * @param count The number of elements.
+	 * @param nonZero Whether 0 is rejected too.
+	 */
+	void fillRandomElements(Element *values, size_t count, bool nonZero)
+	{
+		std::vector<uint64_t> words(count * Field::randomWords);
+		this->randomSource->fill(words.data(), words.size());
+
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t *candidate = words.data() + i * Field::randomWords;
+			while (!Field::fromRandomWords(candidate, values[i]) || (nonZero && values[i] == Field::encode(0)))
+				this->randomSource->fill(candidate, Field::randomWords);
+		}
+	}
+
+
+	/**
+	 * Replaces every value with its inverse using a single inversion, as
+	 * Fp61::batchInv does.
+	 *
+	 * @param values The values to invert in place.
+	 */
+	static void invertAll(std::vector<Element> &values)
+	{
+		std::vector<Element> prefix(values.size());
+		Element running = Field::encode(1);
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			prefix[i] = running;
+			running = Field::mul(running, values[i]);
+		}
+
+		// Only a repeated x-value makes a denominator 0
+		if (running == Field::encode(0))
+			throw std::invalid_argument("Error: Two or more of the provided shares had the same x-value.");
+
+		Element inverse = Field::inv(running);
+		for (size_t i = values.size(); i-- > 0;)
+		{
+			Element value = values[i];
+			values[i] = Field::mul(inverse, prefix[i]);
+			inverse = Field::mul(inverse, value);
+		}
+	}
+};
+
+
+/**
+ * The 2^61 - 1 field keeps the optimized engine: difference tables, SIMD
+ * evaluation, threads and cached recovery plans. Its shares are stored as
+ * CompactShares, which convert to std::vector<Share>.
+ */
+template <>
+class SecretSharing<Fp61> {
+public:
+	using Element = uint64_t;
+	using Share = ::Share;
+
+	SecretSharing(uint64_t secret, uint64_t threshold, std::shared_ptr<RandomSource> randomSource = nullptr)
+	: engine(secret, threshold, std::move(randomSource))
+	{
+	}
+
+	uint64_t getNumShares() const
+	{
+		return this->engine.getNumShares();
+	}
+
+	uint64_t getThreshold() const
+	{
+		return this->engine.getThreshold();
+	}
+
+	const CompactShares& getShares() const
+	{
+		return this->engine.getShares();
+	}
+
+	void generateAdditionalShares(uint64_t numToGenerate)
+	{
+		this->engine.generateAdditionalShares(numToGenerate);
+	}
+
+	static uint64_t recoverSecret(const std::vector<Share> &userShares)
+	{
+		return ShamirsSecretSharing::recoverSecret(userShares);
+	}
+
+private:
+	ShamirsSecretSharing engine;
+};
+
+
+// Secrets of up to 127 bits, for instance a 16-byte key with its top bit clear
+using SecretSharing127 = SecretSharing<Fp127>;
+
+#endif
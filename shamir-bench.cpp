@@ -0,0 +1,609 @@
+#include "shamir.h"
+#include "custody-client.h"
+#include "custody-server.h"
+#include "fp127.h"
+#include "fp61.h"
+#include "incremental-recovery.h"
+#include "montgomery-field.h"
+#include "polynomial-evaluator.h"
+#include "random-source.h"
+#include "recovery-plan.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+
+// The settings for a run, from the command line
+struct BenchOptions {
+	unsigned reps = 10;
+	unsigned maxLog2 = 20;
+	double maxWork = double(1ULL << 31);
+	double budgetSeconds = 2.0;
+	double tolerance = 0.10;
+	unsigned threads = 1;
+	std::string filter;
+	std::string jsonPath;
+	std::string baselinePath;
+};
+
+
+// One benchmark's timings, in nanoseconds per unit of work
+struct Result {
+	std::string name;
+	std::string unit;
+	std::vector<double> samples;
+
+	/**
+	 * Gets a percentile of the samples by the nearest-rank method.
+	 *
+	 * @param q The fraction of samples at or below the result, in (0, 1].
+	 */
+	double percentile(double q) const
+	{
+		std::vector<double> sorted(samples);
+		std::sort(sorted.begin(), sorted.end());
+		size_t rank = static_cast<size_t>(std::ceil(q * sorted.size()));
+		return sorted[std::max<size_t>(rank, 1) - 1];
+	}
+};
+
+
+// Keeps the compiler from discarding the results being timed
+static volatile uint64_t sink;
+
+
+/**
+ * Times a benchmark. One untimed warm-up run comes first, then the benchmark
+ * is repeated until there are options.reps samples, or until the time budget
+ * is spent once there are at least 3.
+ *
+ * @param name The benchmark's name.
+ * @param unit What each sample is measured per, e.g. "ns/op".
+ * @param work The number of units of work in one run.
+ * @param setup Untimed preparation before each run.
+ * @param run The code being timed.
+ * @param options The settings for the run.
+ *
+ * @return The timings.
+ */
+Result measure(const std::string &name, const std::string &unit, double work,
+	const std::function<void()> &setup, const std::function<void()> &run, const BenchOptions &options)
+{
+	using Clock = std::chrono::steady_clock;
+
+	setup();
+	run();
+
+	Result result{name, unit, {}};
+	Clock::time_point begin = Clock::now();
+	while (result.samples.size() < options.reps)
+	{
+		setup();
+		Clock::time_point start = Clock::now();
+		run();
+		std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+		result.samples.push_back(elapsed.count() / work);
+
+		std::chrono::duration<double> total = Clock::now() - begin;
+		if (result.samples.size() >= 3 && total.count() > options.budgetSeconds)
+			break;
+	}
+
+	return result;
+}
+
+
+void printResult(const Result &result)
+{
+	std::cout << std::left << std::setw(44) << result.name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(5) << result.samples.size()
+		<< std::setw(12) << result.percentile(0)
+		<< std::setw(12) << result.percentile(0.5)
+		<< std::setw(12) << result.percentile(0.9)
+		<< std::setw(12) << result.percentile(0.99)
+		<< std::setw(12) << result.percentile(1)
+		<< "  " << result.unit << std::endl;
+}
+
+
+std::vector<uint64_t> randomElements(size_t count, uint64_t min, std::mt19937_64 &rng)
+{
+	std::uniform_int_distribution<uint64_t> distribution(min, Fp61::p-1);
+	std::vector<uint64_t> values(count);
+	for (uint64_t &value : values)
+		value = distribution(rng);
+	return values;
+}
+
+
+/**
+ * The field operations behind modMultiply, modPower and getMultiplicativeInverse,
+ * which all delegate to Fp61.
+ */
+void benchmarkField(std::vector<Result> &results, const BenchOptions &options, std::mt19937_64 &rng)
+{
+	std::vector<uint64_t> a = randomElements(4096, 1, rng), b = randomElements(4096, 1, rng);
+
+	// A dependent chain, as in Horner's scheme
+	results.push_back(measure("fp61/mul", "ns/op", 64.0 * a.size(), [] {}, [&]
+	{
+		uint64_t product = 1;
+		for (int round = 0; round < 64; round++)
+			for (uint64_t value : a)
+				product = Fp61::mul(product, value);
+		sink = product;
+	}, options));
+
+	results.push_back(measure("fp61/pow", "ns/op", double(a.size()), [] {}, [&]
+	{
+		uint64_t total = 0;
+		for (size_t i = 0; i < a.size(); i++)
+			total += Fp61::pow(a[i], b[i]);
+		sink = total;
+	}, options));
+
+	results.push_back(measure("fp61/inv", "ns/op", double(a.size()), [] {}, [&]
+	{
+		uint64_t total = 0;
+		for (uint64_t value : a)
+			total += Fp61::inv(value);
+		sink = total;
+	}, options));
+
+	std::vector<uint64_t> inverses;
+	results.push_back(measure("fp61/batchInv", "ns/op", double(a.size()), [&] { inverses = a; }, [&]
+	{
+		Fp61::batchInv(inverses);
+		sink = inverses[0];
+	}, options));
+
+	// The same chain in the other fields SecretSharing can be instantiated with
+	std::vector<__uint128_t> wide(a.size());
+	for (size_t i = 0; i < a.size(); i++)
+		wide[i] = ((__uint128_t(a[i]) << 64) | b[i]) & Fp127::p;
+	results.push_back(measure("fp127/mul", "ns/op", 64.0 * wide.size(), [] {}, [&]
+	{
+		__uint128_t product = 1;
+		for (int round = 0; round < 64; round++)
+			for (__uint128_t value : wide)
+				product = Fp127::mul(product, value);
+		sink = static_cast<uint64_t>(product);
+	}, options));
+
+	using Montgomery61 = MontgomeryField<Fp61::p>;
+	results.push_back(measure("montgomery61/mul", "ns/op", 64.0 * a.size(), [] {}, [&]
+	{
+		uint64_t product = Montgomery61::one;
+		for (int round = 0; round < 64; round++)
+			for (uint64_t value : a)
+				product = Montgomery61::mul(product, value);
+		sink = product;
+	}, options));
+}
+
+
+/**
+ * evaluatePolynomial, through the evaluator it uses, with every kernel this CPU supports.
+ */
+void benchmarkEvaluator(std::vector<Result> &results, const BenchOptions &options, std::mt19937_64 &rng)
+{
+	const std::pair<PolynomialEvaluator::Kernel, const char*> kernels[] = {
+		{PolynomialEvaluator::Kernel::Scalar, "scalar"},
+		{PolynomialEvaluator::Kernel::AVX2, "avx2"},
+		{PolynomialEvaluator::Kernel::AVX512, "avx512"}
+	};
+	PolynomialEvaluator::Kernel original = PolynomialEvaluator::getKernel();
+
+	std::vector<uint64_t> xValues = randomElements(4096, 1, rng), yValues(xValues.size());
+	for (size_t k : {16, 256, 4096})
+	{
+		std::vector<uint64_t> coefficients = randomElements(k, 0, rng);
+		for (const auto &[kernel, kernelName] : kernels)
+		{
+			if (!PolynomialEvaluator::setKernel(kernel))
+				continue;
+
+			std::string name = "evaluatePolynomial/k=" + std::to_string(k) + "/" + kernelName;
+			results.push_back(measure(name, "ns/point", double(xValues.size()), [] {}, [&]
+			{
+				PolynomialEvaluator::evaluate(coefficients.data(), k, xValues.data(), yValues.data(), xValues.size());
+				sink = yValues[0];
+			}, options));
+		}
+	}
+
+	PolynomialEvaluator::setKernel(original);
+}
+
+
+/**
+ * The CSPRNG behind the dealers' coefficients, with every kernel this CPU 
+ * supports, and the dealer setup it dominates at large thresholds.
+ */
+void benchmarkRandom(std::vector<Result> &results, const BenchOptions &options)
+{
+	const std::pair<ChaCha20Rng::Kernel, const char*> kernels[] = {
+		{ChaCha20Rng::Kernel::Scalar, "scalar"},
+		{ChaCha20Rng::Kernel::AVX2, "avx2"},
+		{ChaCha20Rng::Kernel::AVX512, "avx512"}
+	};
+	ChaCha20Rng::Kernel original = ChaCha20Rng::getKernel();
+
+	ChaCha20Rng rng;
+	std::vector<uint64_t> values(1 << 16);
+	for (const auto &[kernel, kernelName] : kernels)
+	{
+		if (!ChaCha20Rng::setKernel(kernel))
+			continue;
+
+		results.push_back(measure(std::string("chacha20/fillFieldElements/") + kernelName, "ns/op", double(values.size()), [] {}, [&]
+		{
+			rng.fillFieldElements(values.data(), values.size());
+			sink = values[0];
+		}, options));
+	}
+	ChaCha20Rng::setKernel(original);
+
+	const uint64_t k = 1 << 20;
+	results.push_back(measure("dealer/construct/k=2^20", "ms", 1e6, [] {}, [&]
+	{
+		ShamirsSecretSharing sss(42, k);
+		sink = sss.getThreshold();
+	}, options));
+}
+
+
+/**
+ * generateAdditionalShares over k and n, and recoverSecret over k from
+ * consecutive and from scattered x-values. Recovery takes the same time for
+ * any y-values, so random ones stand in for real shares. Combinations with
+ * more than options.maxWork field operations are skipped.
+ */
+void benchmarkShares(std::vector<Result> &results, const BenchOptions &options, std::mt19937_64 &rng)
+{
+	// 2, then every 4th power of 2
+	std::vector<uint64_t> sizes = {2};
+	for (unsigned e = 4; e <= options.maxLog2; e += 4)
+		sizes.push_back(1ULL << e);
+
+	for (uint64_t k : sizes)
+	{
+		for (uint64_t n : sizes)
+		{
+			if (n < k || double(k) * n > options.maxWork)
+				continue;
+
+			std::string name = "generateAdditionalShares/k=" + std::to_string(k) + "/n=" + std::to_string(n);
+			if (name.find(options.filter) == std::string::npos)
+				continue;
+
+			std::unique_ptr<ShamirsSecretSharing> sss;
+			results.push_back(measure(name, "ns/share", double(n),
+				[&] { sss = std::make_unique<ShamirsSecretSharing>(123456789, k); },
+				[&] { sss->generateAdditionalShares(n); }, options));
+			printResult(results.back());
+		}
+	}
+
+	for (uint64_t k : sizes)
+	{
+		std::vector<uint64_t> yValues = randomElements(k, 0, rng);
+		std::vector<uint64_t> scattered = randomElements(k, 1, rng);
+		std::sort(scattered.begin(), scattered.end());
+		scattered.erase(std::unique(scattered.begin(), scattered.end()), scattered.end());
+
+		std::vector<Share> consecutiveShares, scatteredShares;
+		for (size_t i = 0; i < k; i++)
+			consecutiveShares.push_back({i+1, yValues[i]});
+		for (size_t i = 0; i < scattered.size(); i++)
+			scatteredShares.push_back({scattered[i], yValues[i]});
+
+		std::string name = "recoverSecret/consecutive/k=" + std::to_string(k);
+		if (name.find(options.filter) != std::string::npos)
+		{
+			results.push_back(measure(name, "ns/share", double(k), [] {},
+				[&] { sink = ShamirsSecretSharing::recoverSecret(consecutiveShares); }, options));
+			printResult(results.back());
+		}
+
+		// Cleared so each run builds its recovery plan, as a new set of holders would
+		name = "recoverSecret/scattered/k=" + std::to_string(k);
+		if (name.find(options.filter) != std::string::npos)
+		{
+			results.push_back(measure(name, "ns/share", double(scatteredShares.size()),
+				[] { RecoveryPlanCache::global().clear(); },
+				[&] { sink = ShamirsSecretSharing::recoverSecret(scatteredShares); }, options));
+			printResult(results.back());
+		}
+	}
+}
+
+
+void writeJson(const std::string &path, const std::vector<Result> &results)
+{
+	std::ofstream out(path);
+	out << std::setprecision(6) << "{\n  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result &result = results[i];
+		out << "    {\"name\": \"" << result.name << "\", \"unit\": \"" << result.unit << "\", \"reps\": " << result.samples.size()
+			<< ", \"min\": " << result.percentile(0) << ", \"p50\": " << result.percentile(0.5)
+			<< ", \"p90\": " << result.percentile(0.9) << ", \"max\": " << result.percentile(1) << "}"
+			<< (i+1 < results.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n}\n";
+
+	if (!out)
+		throw std::runtime_error("Error: Couldn't write " + path + ".");
+}
+
+
+/**
+ * Compares the medians against a baseline written by --json.
+ *
+ * @return The number of benchmarks more than options.tolerance slower than the baseline.
+ */
+int compareBaseline(const std::vector<Result> &results, const BenchOptions &options)
+{
+	std::ifstream in(options.baselinePath);
+	if (!in)
+		throw std::runtime_error("Error: Couldn't read " + options.baselinePath + ".");
+
+	std::map<std::string, double> baseline;
+	std::regex entry("\"name\": \"([^\"]+)\".*\"p50\": ([0-9.eE+-]+)");
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::smatch match;
+		if (std::regex_search(line, match, entry))
+			baseline[match[1]] = std::stod(match[2]);
+	}
+
+	std::cout << "\nCOMPARED TO " << options.baselinePath << " (p50)\n";
+	int regressions = 0;
+	for (const Result &result : results)
+	{
+		auto found = baseline.find(result.name);
+		if (found == baseline.end())
+			continue;
+
+		double change = result.percentile(0.5) / found->second - 1;
+		bool regressed = change > options.tolerance;
+		regressions += regressed;
+		std::cout << std::left << std::setw(44) << result.name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << found->second << std::setw(12) << result.percentile(0.5)
+			<< std::showpos << std::setw(9) << 100 * change << '%' << std::noshowpos
+			<< (regressed ? "  REGRESSION" : "") << '\n';
+	}
+
+	return regressions;
+}
+
+
+/**
+ * The work left when the k-th share reaches an IncrementalRecovery, to set 
+ * against recoverSecret/scattered, which does all of it after the last share.
+ */
+void benchmarkIncremental(std::vector<Result> &results, const BenchOptions &options, std::mt19937_64 &rng)
+{
+	const uint64_t k = 4096;
+	std::vector<uint64_t> xValues = randomElements(k, 1, rng), yValues = randomElements(k, 0, rng);
+	std::sort(xValues.begin(), xValues.end());
+	xValues.erase(std::unique(xValues.begin(), xValues.end()), xValues.end());
+
+	IncrementalRecovery waiting(xValues.size());
+	for (size_t i = 0; i + 1 < xValues.size(); i++)
+		waiting.addShare({xValues[i], yValues[i]});
+
+	IncrementalRecovery recovery = waiting;
+	results.push_back(measure("incremental/lastShare/k=" + std::to_string(k), "ms", 1e6, [&] { recovery = waiting; }, [&]
+	{
+		recovery.addShare({xValues.back(), yValues.back()});
+		sink = recovery.getSecret();
+	}, options));
+}
+
+
+/**
+ * Issuing shares to new holders from k existing ones, per new share.
+ */
+void benchmarkEnroll(std::vector<Result> &results, const BenchOptions &options, std::mt19937_64 &rng)
+{
+	const uint64_t k = 1024, m = 256;
+	ShamirsSecretSharing sss(42, k);
+	sss.generateAdditionalShares(k);
+	std::vector<Share> userShares = sss.getShares();
+	std::vector<uint64_t> newXValues = randomElements(m, 1, rng);
+
+	results.push_back(measure("enrollShares/k=" + std::to_string(k) + "/m=" + std::to_string(m), "ns/share", double(m), [] {}, [&]
+	{
+		sink = ShamirsSecretSharing::enrollShares(userShares, newXValues).back().second;
+	}, options));
+}
+
+
+/**
+ * Reads the command line options.
+ *  --reps N         Repetitions of each benchmark (default 10).
+ *  --max-log2 E     The largest k and n are 2^E (default 20).
+ *  --max-work W     Skip generation sweeps of more than W field operations (default 2^31).
+ *  --budget S       Stop repeating a benchmark after S seconds, once it has 3 samples (default 2).
+ *  --filter TEXT    Only run the k and n sweeps whose names contain TEXT.
+ *  --json FILE      Write the results to FILE as JSON.
+ *  --baseline FILE  Compare against a JSON file, failing on regressions.
+ *  --tolerance PCT  The slowdown counted as a regression (default 10).
+ *  --threads N      Threads recoverSecret may use (default 1).
+ *
+ * @return False if the options are invalid.
+ */
+bool parseOptions(int argc, char *argv[], BenchOptions &options)
+{
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (i+1 >= argc)
+				return false;
+
+			std::string value = argv[++i];
+			if (arg == "--reps")
+				options.reps = std::max(1UL, std::stoul(value));
+			else if (arg == "--max-log2")
+				options.maxLog2 = std::min(20UL, std::stoul(value));
+			else if (arg == "--max-work")
+				options.maxWork = std::stod(value);
+			else if (arg == "--budget")
+				options.budgetSeconds = std::stod(value);
+			else if (arg == "--filter")
+				options.filter = value;
+			else if (arg == "--json")
+				options.jsonPath = value;
+			else if (arg == "--baseline")
+				options.baselinePath = value;
+			else if (arg == "--tolerance")
+				options.tolerance = std::stod(value) / 100;
+			else if (arg == "--threads")
+				options.threads = std::max(1UL, std::stoul(value));
+			else
+				return false;
+		}
+	}
+	catch (const std::exception &e)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * The custody daemon on a local socket: the latency of one request at a time, 
+ * and the throughput with many requests in flight, where the workers batch.
+ */
+void benchmarkDaemon(std::vector<Result> &results, const BenchOptions &options)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::string path = "shamir-bench-" + std::to_string(::getpid()) + ".sock";
+	CustodyServer server(path, std::max(1u, std::thread::hardware_concurrency()));
+	std::thread loop(&CustodyServer::run, &server);
+
+	{
+		CustodyClient client(path);
+		std::vector<Share> shares = client.split(42, 3, 5);
+		std::vector<uint64_t> payload = {1, shares[0].second, 3, shares[2].second, 5, shares[4].second};
+
+		Result latency{"daemon/recover/k=3/latency", "ns/request", {}};
+		Clock::time_point begin = Clock::now();
+		for (unsigned r = 0; r < 100 * options.reps; r++)
+		{
+			Clock::time_point start = Clock::now();
+			client.send(CustodyProtocol::Opcode::Recover, payload);
+			sink = client.receive().words[0];
+			std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+			latency.samples.push_back(elapsed.count());
+
+			std::chrono::duration<double> total = Clock::now() - begin;
+			if (total.count() > options.budgetSeconds)
+				break;
+		}
+		results.push_back(latency);
+
+		// A window of requests kept in flight on one connection
+		const size_t numRequests = 1 << 14, window = 256;
+		results.push_back(measure("daemon/recover/k=3/pipelined", "ns/request", double(numRequests), [] {}, [&]
+		{
+			size_t sent = 0, received = 0;
+			while (received < numRequests)
+			{
+				while (sent < numRequests && sent - received < window)
+				{
+					client.send(CustodyProtocol::Opcode::Recover, payload);
+					sent++;
+				}
+				sink = client.receive().words[0];
+				received++;
+			}
+		}, options));
+
+		results.push_back(measure("daemon/split/k=3,n=5/pipelined", "ns/request", double(numRequests), [] {}, [&]
+		{
+			size_t sent = 0, received = 0;
+			while (received < numRequests)
+			{
+				while (sent < numRequests && sent - received < window)
+				{
+					client.send(CustodyProtocol::Opcode::Split, {sent, 3, 5});
+					sent++;
+				}
+				sink = client.receive().words[0];
+				received++;
+			}
+		}, options));
+	}
+
+	server.stop();
+	loop.join();
+}
+
+
+int main(int argc, char *argv[])
+{
+	BenchOptions options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--reps N] [--max-log2 E] [--max-work W] [--budget S] [--filter TEXT]"
+			<< " [--json FILE] [--baseline FILE] [--tolerance PCT] [--threads N]" << std::endl;
+		return 1;
+	}
+	ShamirsSecretSharing::setRecoveryThreads(options.threads);
+
+	std::mt19937_64 rng(42);
+	std::vector<Result> results;
+
+	std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(5) << "reps"
+		<< std::setw(12) << "min" << std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99" << std::setw(12) << "max" << '\n';
+
+	benchmarkField(results, options, rng);
+	benchmarkEvaluator(results, options, rng);
+	benchmarkRandom(results, options);
+	benchmarkIncremental(results, options, rng);
+	benchmarkEnroll(results, options, rng);
+	benchmarkDaemon(results, options);
+	for (const Result &result : results)
+		printResult(result);
+	benchmarkShares(results, options, rng);
+
+	try
+	{
+		if (!options.jsonPath.empty())
+			writeJson(options.jsonPath, results);
+		if (!options.baselinePath.empty() && compareBaseline(results, options) > 0)
+			return 1;
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include "custody-server.h"
+
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+// The server being run, for the signal handler
+static CustodyServer *activeServer = nullptr;
+
+
+// stop() only writes to an eventfd, so it's safe here
+void handleSignal(int) 
+{
+	if (activeServer)
+		activeServer->stop();
+}
+
+
+bool parseNumber(const char *arg, unsigned &value) 
+{
+	const char *last = arg + std::strlen(arg);
+	auto [ptr, error] = std::from_chars(arg, last, value);
+	return error == std::errc() && ptr == last && ptr != arg;
+}
+
+
+/**
+ * Reads the command line options.
+ *  --socket PATH  Listen on the Unix domain socket at PATH.
+ *  --workers N    Use N worker threads (default: one per core).
+ * 
+ * @return False if the options are invalid.
+ */
+bool parseOptions(int argc, char *argv[], std::string &socketPath, unsigned &numWorkers) 
+{
+	for (int i = 1; i < argc; i++) 
+	{
+		std::string arg = argv[i];
+		if (arg == "--socket" && i+1 < argc)
+			socketPath = argv[++i];
+		else if (arg == "--workers" && i+1 < argc) 
+		{
+			if (!parseNumber(argv[++i], numWorkers) || numWorkers < 1 || numWorkers > 1024)
+				return false;
+		}
+		else
+			return false;
+	}
+
+	return !socketPath.empty();
+}
+
+
+int main(int argc, char *argv[]) 
+{
+	std::string socketPath;
+	unsigned numWorkers = std::max(1u, std::thread::hardware_concurrency());
+	if (!parseOptions(argc, argv, socketPath, numWorkers)) 
+	{
+		std::cerr << "Usage: " << argv[0] << " --socket PATH [--workers N]" << std::endl;
+		return 1;
+	}
+
+	try 
+	{
+		CustodyServer server(socketPath, numWorkers);
+		activeServer = &server;
+		std::signal(SIGINT, handleSignal);
+		std::signal(SIGTERM, handleSignal);
+
+		std::cerr << "Listening on " << socketPath << " with " << numWorkers << " workers." << std::endl;
+		server.run();
+
+		std::signal(SIGINT, SIG_DFL);
+		std::signal(SIGTERM, SIG_DFL);
+		activeServer = nullptr;
+	}
+	catch (const std::exception &e) 
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
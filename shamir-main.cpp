@@ -1,9 +1,32 @@
 #include "shamir.h"
+#include "bulk-processor.h"
+#include "incremental-recovery.h"
+#include "stats.h"
 
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
+#include <string>
 #include <unordered_set>
+#include <vector>
+
+
+// The command line options. command is empty for the interactive menu.
+struct Options {
+	std::string command;
+	unsigned numThreads = 1;
+	bool stats = false;
+	uint64_t threshold = 0;
+	uint64_t numShares = 0;
+	std::string input;
+	std::string output;
+	std::string binaryPrefix;
+	std::vector<std::string> shareFiles;
+};
 
 
 /**
@@ -15,11 +38,9 @@
  */
 void viewShares(ShamirsSecretSharing &sssInstance) 
 {
-	std::vector<Share> shares = sssInstance.getShares();
-
 	std::cout << "\nALL SHARES\n";
-	for (size_t i = 0; i < shares.size(); i++)
-		std::cout << shares[i].first << ' ' << shares[i].second << '\n';
+	for (const Share share : sssInstance.getShares())
+		std::cout << share.first << ' ' << share.second << '\n';
 }
 
 
@@ -57,10 +78,11 @@ uint64_t readUInt64(const std::string &prompt)
  * @param secret The secret to hide in the constant term of the polynomial.
  * @param k The number of shares required to recover the secret. Leads to a 
  *        degree k-1 polynomial being generated.
+ * @param numThreads The number of threads used to generate shares.
  * 
  * @return The ShamirsSecretSharing instance.
  */
-ShamirsSecretSharing hideSecret() 
+ShamirsSecretSharing hideSecret(unsigned numThreads) 
 {
 	while (true) 
 	{
@@ -72,6 +94,7 @@ ShamirsSecretSharing hideSecret()
 		try 
 		{
 			ShamirsSecretSharing sss(secret, k);
+			sss.setNumThreads(numThreads);
 			if (n > 0)
 			{
 				sss.generateAdditionalShares(n);
@@ -116,7 +139,9 @@ void generateAdditionalShares(ShamirsSecretSharing &sssInstance) {
 
 /**
  * Prompts the user to input shares one at a time until k shares have been
- * inputted. The secret is recovered using the Lagrange Interpolation Formula.
+ * inputted. Each share is combined as soon as it's entered, so a share that 
+ * is out of range or repeats an x-value is rejected straight away, and the 
+ * secret is ready as soon as the k-th share is in.
  * 
  * @param k The number of shares to be combined to recover the secret.
  * 
@@ -126,39 +151,215 @@ void recoverSecret(uint64_t k)
 {
 	std::cout << "\nRECOVER SECRET BY COMBINING K SHARES\n";
 
-	std::vector<Share> shares(k);
-	for (uint64_t i = 1; i <= k; i++) 
+	IncrementalRecovery recovery(k);
+	while (!recovery.isComplete()) 
 	{
-		std::cout << "Enter share #" << i << "/" << k << " in the format x y: ";
+		std::cout << "Enter share #" << recovery.getNumShares() + 1 << "/" << k << " in the format x y: ";
 		uint64_t x = readUInt64("");
 		uint64_t y = readUInt64("");
 
-		shares[i-1] = {x, y};
+		try 
+		{
+			recovery.addShare({x, y});
+		} 
+		catch (const std::domain_error &e) 
+		{
+			std::cerr << e.what() << std::endl;
+		} 
+		catch (const std::invalid_argument &e) 
+		{
+			std::cerr << e.what() << std::endl;
+		}
+	}
+
+	std::cout << "Secret: " << recovery.getSecret() << '\n';
+}
+
+
+/**
+ * Parses a whole command line argument as a number.
+ * 
+ * @return False if the argument isn't a number.
+ */
+bool parseNumber(const char *arg, uint64_t &value) 
+{
+	const char *last = arg + std::strlen(arg);
+	auto [ptr, error] = std::from_chars(arg, last, value);
+	return error == std::errc() && ptr == last && ptr != arg;
+}
+
+
+/**
+ * Reads the command line options.
+ *  --threads N      Use N threads (default 1).
+ *  split            Split the secrets read one per line, with:
+ *    -k K             The number of shares needed to recover each secret.
+ *    -n N             The number of shares of each secret.
+ *    --binary PREFIX  Write one share file per holder, PREFIX.1 to PREFIX.n.
+ *  combine          Recover the secret of each line of x y pairs, or of 
+ *                   every secret held in the share files given.
+ *  --input FILE     Read from FILE instead of stdin.
+ *  --output FILE    Write to FILE instead of stdout.
+ * 
+ * @param options Set to the options given.
+ * 
+ * @return False if the options are invalid.
+ */
+bool parseOptions(int argc, char *argv[], Options &options) 
+{
+	int i = 1;
+	if (i < argc && (std::strcmp(argv[i], "split") == 0 || std::strcmp(argv[i], "combine") == 0))
+		options.command = argv[i++];
+	bool split = options.command == "split", combine = options.command == "combine";
+
+	for (; i < argc; i++) 
+	{
+		std::string arg = argv[i];
+		bool hasValue = i+1 < argc;
+		uint64_t value;
+
+		if (arg == "--threads" && hasValue) 
+		{
+			if (!parseNumber(argv[++i], value) || value < 1 || value > 1024)
+				return false;
+			options.numThreads = static_cast<unsigned>(value);
+		}
+		else if (split && arg == "-k" && hasValue) 
+		{
+			if (!parseNumber(argv[++i], options.threshold))
+				return false;
+		}
+		else if (split && arg == "-n" && hasValue) 
+		{
+			if (!parseNumber(argv[++i], options.numShares))
+				return false;
+		}
+		else if (split && arg == "--binary" && hasValue)
+			options.binaryPrefix = argv[++i];
+		else if ((split || combine) && arg == "--input" && hasValue)
+			options.input = argv[++i];
+		else if ((split || combine) && arg == "--output" && hasValue)
+			options.output = argv[++i];
+		else if (arg == "--stats")
+			options.stats = true;
+		else if (combine && arg[0] != '-')
+			options.shareFiles.push_back(arg);
+		else
+			return false;
+	}
+
+	if (split && (options.threshold < 2 || options.numShares < options.threshold))
+		return false;
+	if (combine && !options.shareFiles.empty() && !options.input.empty())
+		return false;
+
+	return true;
+}
+
+
+/**
+ * Runs the split or combine command without any prompts, for batch jobs.
+ * 
+ * @param options The command line options.
+ * 
+ * @return The exit code.
+ */
+int runCommand(const Options &options) 
+{
+	std::ios::sync_with_stdio(false);
+
+	std::ifstream inputFile;
+	std::ofstream outputFile;
+	std::istream *in = &std::cin;
+	std::ostream *out = &std::cout;
+	if (!options.input.empty()) 
+	{
+		inputFile.open(options.input, std::ios::binary);
+		if (!inputFile) 
+		{
+			std::cerr << "Error: Couldn't open " << options.input << '.' << std::endl;
+			return 1;
+		}
+		in = &inputFile;
+	}
+	if (!options.output.empty()) 
+	{
+		outputFile.open(options.output, std::ios::binary | std::ios::trunc);
+		if (!outputFile) 
+		{
+			std::cerr << "Error: Couldn't create " << options.output << '.' << std::endl;
+			return 1;
+		}
+		out = &outputFile;
 	}
 
-	uint64_t secret;
 	try 
 	{
-		secret = ShamirsSecretSharing::recoverSecret(shares);
+		BulkProcessor processor(options.numThreads);
+		if (options.command == "split" && options.binaryPrefix.empty())
+			processor.split(*in, *out, options.threshold, options.numShares);
+		else if (options.command == "split")
+			processor.splitToFiles(*in, options.binaryPrefix, options.threshold, options.numShares);
+		else if (options.shareFiles.empty())
+			processor.combine(*in, *out);
+		else
+			processor.combineFiles(options.shareFiles, *out);
 	} 
-	catch (const std::domain_error &e) 
+	catch (const std::exception &e) 
 	{
 		std::cerr << e.what() << std::endl;
-		return;
-	} 
-	catch (const std::invalid_argument &e) 
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * Writes the library's counters and timers to stderr, for --stats.
+ * 
+ * @return Void
+ */
+void printStats() 
+{
+	if (!Stats::enabled) 
 	{
-		std::cerr << e.what() << std::endl;
+		std::cerr << "Stats aren't available: build with -DSSS_STATS." << std::endl;
 		return;
 	}
 
-	std::cout << "Secret: " << secret << '\n';
+	Stats::Snapshot snapshot = Stats::snapshot();
+	std::cerr << "\nSTATS\n";
+	for (size_t i = 0; i < Stats::numCounters; i++)
+		std::cerr << std::left << std::setw(28) << Stats::name(static_cast<Stats::Counter>(i)) 
+			<< snapshot.counters[i] << '\n';
+	for (size_t i = 0; i < Stats::numTimers; i++)
+		std::cerr << std::left << std::setw(28) << Stats::name(static_cast<Stats::Timer>(i)) 
+			<< snapshot.timerCalls[i] << " calls, " << std::fixed << std::setprecision(3) 
+			<< snapshot.timerNanoseconds[i] / 1e6 << " ms\n";
+	std::cerr << std::flush;
 }
 
 
-int main() 
+int main(int argc, char *argv[]) 
 {
-	ShamirsSecretSharing sssInstance = hideSecret();
+	Options options;
+	if (!parseOptions(argc, argv, options)) 
+	{
+		std::cerr << "Usage: " << argv[0] << " [--threads N] [--stats]\n"
+			<< "       " << argv[0] << " split -k K -n N [--binary PREFIX] [--input FILE] [--output FILE] [--threads N] [--stats]\n"
+			<< "       " << argv[0] << " combine [--input FILE | SHARE_FILE...] [--output FILE] [--threads N] [--stats]" << std::endl;
+		return 1;
+	}
+	if (!options.command.empty()) 
+	{
+		int exitCode = runCommand(options);
+		if (options.stats)
+			printStats();
+		return exitCode;
+	}
+
+	ShamirsSecretSharing sssInstance = hideSecret(options.numThreads);
 
 	std::unordered_set<std::string> validChoices = {"1", "2", "3", "4", "q"};
 	while (true) 
@@ -184,10 +385,13 @@ int main()
 		else if (choice == "3")
 			recoverSecret(sssInstance.getThreshold());
 		else if (choice == "4")
-			sssInstance = hideSecret();
+			sssInstance = hideSecret(options.numThreads);
 		else if (choice == "q")
 			break;
 	}
 
+	if (options.stats)
+		printStats();
+
 	return 0;
 }
\ No newline at end of file
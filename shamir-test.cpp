@@ -1,8 +1,28 @@
 #include "shamir.h"
+#include "batch-dealer.h"
+#include "share-stream.h"
+#include "share-file.h"
+#include "bulk-processor.h"
+#include "custody-server.h"
+#include "custody-client.h"
+#include "gf256.h"
+#include "incremental-recovery.h"
+#include "polynomial-evaluator.h"
+#include "polynomial.h"
+#include "lagrange.h"
+#include "recovery-plan.h"
+#include "random-source.h"
+#include "secret-sharing.h"
+#include "stats.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
 
 
 static constexpr uint64_t sssPrime = (1ULL << 61) - 1;
@@ -63,6 +83,957 @@ void RecoverSecret_IsSuccessful_WhenLargeK(int i) {
 }
 
 
+void RecoverSecret_MatchesSerial_WhenUsingRecoveryThreads(int i) {
+    std::cout << "\nTEST #" << i << ": Parallel, vectorized recovery gives the same results as serial recovery.\n";
+
+    // Every difference kernel agrees with the scalar kernel, including the lane tails
+    std::vector<uint64_t> roots, points = {0, 5, sssPrime-1, 12345, 7, 99, 1ULL << 60};
+    for (uint64_t r = 1; r <= 45; r++)
+        roots.push_back(r * 0x9E3779B97F4A7C15ULL % sssPrime);
+    roots.push_back(5);
+    PolynomialEvaluator::Kernel original = PolynomialEvaluator::getKernel();
+    PolynomialEvaluator::setKernel(PolynomialEvaluator::Kernel::Scalar);
+    std::vector<uint64_t> expected(points.size());
+    PolynomialEvaluator::productsOfDifferences(roots.data(), roots.size(), points.data(), expected.data(), points.size());
+    for (PolynomialEvaluator::Kernel kernel : {PolynomialEvaluator::Kernel::AVX2, PolynomialEvaluator::Kernel::AVX512})
+    {
+        if (!PolynomialEvaluator::setKernel(kernel))
+            continue;
+        std::vector<uint64_t> products(points.size());
+        PolynomialEvaluator::productsOfDifferences(roots.data(), roots.size(), points.data(), products.data(), points.size());
+        if (products != expected)
+            throw std::logic_error("Failed: Expected the SIMD kernel's products == the scalar kernel's products.");
+    }
+    PolynomialEvaluator::setKernel(original);
+
+    // The subproduct tree split between threads
+    ThreadPool pool(3);
+    std::vector<uint64_t> treeRoots;
+    for (uint64_t r = 1; r <= 5000; r++)
+        treeRoots.push_back(r * r * 7919 % sssPrime);
+    if (Polynomial::derivativeAtRoots(treeRoots, &pool) != Polynomial::derivativeAtRoots(treeRoots))
+        throw std::logic_error("Failed: Expected the parallel subproduct tree == the serial subproduct tree.");
+
+    // Scattered shares use the split denominators, and many consecutive shares the split dot product
+    uint64_t secret = 314159265358979, k = 3000;
+    ShamirsSecretSharing sss(secret, k);
+    std::vector<Share> scattered = sss.getSharesAt(treeRoots);
+    scattered.resize(k);
+    std::vector<Share> consecutive;
+    for (uint64_t x = 1; x <= RecoveryPlan::parallelThreshold + 3; x++)
+        consecutive.push_back({x, x * 2654435761ULL % sssPrime});
+
+    RecoveryPlanCache::global().clear();
+    uint64_t serialScattered = ShamirsSecretSharing::recoverSecret(scattered);
+    uint64_t serialConsecutive = ShamirsSecretSharing::recoverSecret(consecutive);
+
+    ShamirsSecretSharing::setRecoveryThreads(3);
+    RecoveryPlanCache::global().clear();
+    uint64_t parallelScattered = ShamirsSecretSharing::recoverSecret(scattered);
+    uint64_t parallelConsecutive = ShamirsSecretSharing::recoverSecret(consecutive);
+    ShamirsSecretSharing::setRecoveryThreads(1);
+
+    std::cout << "recoveredSecret: " << parallelScattered << " | secret: " << secret << '\n';
+    if (parallelScattered != secret || serialScattered != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+    if (parallelConsecutive != serialConsecutive)
+        throw std::logic_error("Failed: Expected the parallel dot product == the serial dot product.");
+}
+
+
+void IncrementalRecovery_MatchesRecoverSecret_WhenSharesArriveAndLeave(int i) {
+    std::cout << "\nTEST #" << i << ": IncrementalRecovery recovers the secret as shares are added and removed.\n";
+
+    uint64_t secret = 2718281828459045, k = 7;
+    ShamirsSecretSharing sss(secret, k);
+    std::vector<Share> shares = sss.getSharesAt({3, 90, 14, 1, 77, 5, 1000, 42, 8, 9});
+
+    IncrementalRecovery recovery(k);
+    for (uint64_t s = 0; s < k - 1; s++)
+    {
+        if (recovery.addShare(shares[s]))
+            throw std::logic_error("Failed: Expected the recovery to be incomplete before k shares.");
+    }
+
+    bool threw = false;
+    try {
+        recovery.getSecret();
+    } catch (const std::domain_error &e) {
+        threw = true;
+    }
+    if (!threw)
+        throw std::logic_error("Failed: Expected getSecret to throw std::domain_error before k shares.");
+
+    if (!recovery.addShare(shares[k-1]) || recovery.getSecret() != secret)
+        throw std::logic_error("Failed: Expected the secret once the k-th share arrives.");
+
+    threw = false;
+    try {
+        recovery.addShare({shares[2].first, 5});
+    } catch (const std::invalid_argument &e) {
+        threw = true;
+    }
+    if (!threw || recovery.getNumShares() != k)
+        throw std::logic_error("Failed: Expected a repeated x-value to throw std::invalid_argument.");
+
+    // A share in the middle and the newest share leave, then others replace them
+    if (!recovery.removeShare(90) || !recovery.removeShare(shares[k-1].first) || recovery.removeShare(12345))
+        throw std::logic_error("Failed: Expected removeShare to find exactly the added shares.");
+    if (recovery.isComplete())
+        throw std::logic_error("Failed: Expected the recovery to be incomplete after removals.");
+    recovery.addShare(shares[7]);
+    recovery.addShare(shares[8]);
+
+    uint64_t recoveredSecret = recovery.getSecret();
+    std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+    if (recoveredSecret != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret after removals.");
+
+    recovery.addShare(shares[9]);
+    if (recovery.getSecret() != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret with more than k shares.");
+}
+
+
+void EnrollShares_MatchesDealerShares_WhenDealerIsGone(int i) {
+    std::cout << "\nTEST #" << i << ": enrollShares issues the dealer's shares at new x-values from k shares.\n";
+
+    uint64_t secret = 1618033988749894, k = 40;
+    std::vector<uint64_t> newXValues;
+    for (uint64_t x = 1; x <= 300; x++)
+        newXValues.push_back(x * x * 104729 % sssPrime);
+    newXValues.push_back(5);
+
+    std::vector<Share> userShares, expected;
+    {
+        ShamirsSecretSharing sss(secret, k);
+        sss.generateAdditionalShares(k);
+        userShares = sss.getShares();
+        expected = sss.getSharesAt(newXValues);
+    }
+
+    std::reverse(userShares.begin(), userShares.end());
+    std::vector<Share> enrolled = ShamirsSecretSharing::enrollShares(userShares, newXValues);
+    if (enrolled != expected)
+        throw std::logic_error("Failed: Expected the enrolled shares == the dealer's shares.");
+
+    ShamirsSecretSharing::setRecoveryThreads(3);
+    std::vector<Share> enrolledInParallel = ShamirsSecretSharing::enrollShares(userShares, newXValues);
+    ShamirsSecretSharing::setRecoveryThreads(1);
+    if (enrolledInParallel != expected)
+        throw std::logic_error("Failed: Expected the enrolled shares to be the same with recovery threads.");
+
+    // The new holders alone can recover the secret
+    std::vector<Share> newHolders(enrolled.begin(), enrolled.begin() + k);
+    uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret(newHolders);
+    std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+    if (recoveredSecret != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret from enrolled shares.");
+
+    // Without any shares there's no polynomial to evaluate
+    try
+    {
+        ShamirsSecretSharing::enrollShares({}, {7});
+        throw std::logic_error("Failed: Expected invalid argument to be thrown.");
+    }
+    catch (const std::invalid_argument &e) { /* Do nothing, test passed */ }
+
+    try {
+        ShamirsSecretSharing::enrollShares(userShares, {7, 0});
+    } catch (const std::domain_error &e) {
+        return;
+    }
+    throw std::logic_error("Failed: Expected enrolling x = 0 to throw std::domain_error.");
+}
+
+
+void RecoverSecret_IsSuccessful_WhenSharesAreOutOfOrder(int i) {
+    std::cout << "\nTEST #" << i << ": recoverSecret recovers the secret from any k shares in any order.\n";
+    
+    uint64_t secret = 55555555555, n = 40, k = 9;   
+    std::cout << "secret = " << secret << " | n = " << n << " | k = " << k << '\n'; 
+
+    ShamirsSecretSharing sss(secret, k);
+    sss.generateAdditionalShares(n);
+    std::vector<Share> shares = sss.getShares();
+
+    std::vector<Share> subset = {shares[39], shares[2], shares[17], shares[0], shares[25], shares[11], shares[30], shares[7], shares[21]};
+    uint64_t recoveredSecret = sss.recoverSecret(subset);
+    std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+    
+    if (recoveredSecret != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+}
+
+
+void RecoverSecret_IsSuccessful_WhenXValuesAreEvenlySpaced(int i) {
+    std::cout << "\nTEST #" << i << ": recoverSecret recovers the secret from evenly spaced x-values in any order.\n";
+
+    uint64_t secret = 1618033988, n = 300, k = 7;   
+    std::cout << "secret = " << secret << " | n = " << n << " | k = " << k << '\n'; 
+
+    ShamirsSecretSharing sss(secret, k);
+    sss.generateAdditionalShares(n);
+    std::vector<Share> shares = sss.getShares();
+
+    std::vector<std::vector<size_t>> subsets = {
+        {0, 1, 2, 3, 4, 5, 6},
+        {100, 101, 102, 103, 104, 105, 106},
+        {270, 240, 210, 180, 150, 120, 90},
+        {5, 3, 6, 0, 2, 4, 1}
+    };
+    for (const auto &subset : subsets)
+    {
+        std::vector<Share> userShares;
+        for (size_t s : subset)
+            userShares.push_back(shares[s]);
+
+        uint64_t first, step;
+        std::vector<uint64_t> xValues;
+        for (const Share &share : userShares)
+            xValues.push_back(share.first);
+        std::cout << "evenly spaced as given: " << Lagrange::isArithmeticProgression(xValues, first, step) << '\n';
+
+        uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret(userShares);
+        std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+        if (recoveredSecret != secret)
+            throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+    }
+
+    // The closed form agrees with the weights straight from the definition
+    std::vector<uint64_t> xValues = {9, 14, 19, 24, 29, 34, 39, 44};
+    std::vector<uint64_t> closedForm = Lagrange::weightsAtZeroArithmetic(9, 5, xValues.size());
+    for (size_t a = 0; a < xValues.size(); a++)
+    {
+        uint64_t numerator = 1, denominator = 1;
+        for (size_t b = 0; b < xValues.size(); b++)
+        {
+            if (a == b)
+                continue;
+            numerator = Fp61::mul(numerator, Fp61::neg(xValues[b]));
+            denominator = Fp61::mul(denominator, Fp61::sub(xValues[a], xValues[b]));
+        }
+        if (closedForm[a] != Fp61::mul(numerator, Fp61::inv(denominator)))
+            throw std::logic_error("Failed: Expected the closed form weights == the general weights.");
+    }
+}
+
+
+void CompactShares_RecoversSecret_WhenPacked(int i) {
+    std::cout << "\nTEST #" << i << ": Compact shares recover the secret without expanding, in either layout.\n";
+
+    uint64_t secret = 1732050807, n = 1000, k = 9;
+    ShamirsSecretSharing sss(secret, k);
+    sss.generateAdditionalShares(n);
+    const CompactShares &shares = sss.getShares();
+
+    CompactShares packed(shares, CompactShares::Layout::Packed61);
+    std::cout << "bytes: " << shares.getNumBytes() << " | packed bytes: " << packed.getNumBytes() << '\n';
+    if (packed != shares || packed.getNumBytes() >= shares.getNumBytes())
+        throw std::logic_error("Failed: Expected the packed shares == the shares in fewer bytes.");
+
+    std::vector<Share> expanded = packed;
+    for (size_t s = 0; s < n; s++)
+    {
+        if (expanded[s] != Share(s+1, shares.getY(s)) || packed[s] != expanded[s])
+            throw std::logic_error("Failed: Expected the packed share == the original share.");
+    }
+
+    // Any k consecutive shares, packed starting part way through a word
+    CompactShares window(500, CompactShares::Layout::Packed61);
+    for (size_t s = 499; s < 499 + k; s++)
+        window.push_back(shares.getY(s));
+    window.setY(3, shares.getY(502));
+
+    uint64_t fromShares = ShamirsSecretSharing::recoverSecret(shares);
+    uint64_t fromWindow = ShamirsSecretSharing::recoverSecret(window);
+    std::cout << "recoveredSecret: " << fromShares << " | from window: " << fromWindow << " | secret: " << secret << '\n';
+    if (fromShares != secret || fromWindow != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+
+    window.resize(k-1);
+    window.resize(k);
+    if (window.getY(k-1) != 0)
+        throw std::logic_error("Failed: Expected a re-grown share to be cleared.");
+}
+
+
+void ShareRange_MatchesDirectShares_WhenReadInAnyOrder(int i) {
+    std::cout << "\nTEST #" << i << ": A lazy share range gives the same shares read forwards or at random.\n";
+
+    uint64_t secret = 2236067977, k = 12;
+    ShamirsSecretSharing sss(secret, k);
+    sss.generateAdditionalShares(50);
+
+    // Far out, without generating anything before it
+    uint64_t firstX = 1000000000, count = 100;
+    ShareRange range = sss.getShareRange(firstX, count);
+    std::vector<uint64_t> xValues;
+    for (uint64_t x = firstX; x < firstX + count; x++)
+        xValues.push_back(x);
+    std::vector<Share> expected = sss.getSharesAt(xValues);
+
+    std::vector<Share> streamed(range.begin(), range.end());
+    if (streamed != expected)
+        throw std::logic_error("Failed: Expected the streamed shares == the directly evaluated shares.");
+
+    for (size_t s : {99, 0, 57, 58, 3})
+    {
+        if (range[s] != expected[s] || *std::next(range.begin(), s) != expected[s])
+            throw std::logic_error("Failed: Expected the random access share == the directly evaluated share.");
+    }
+
+    ShareRange::const_iterator it = std::next(range.begin(), 40);
+    for (size_t s = 40; s < 60; s++)
+    {
+        if (*it != expected[s] || *it++ != expected[s])
+            throw std::logic_error("Failed: Expected the iterated share == the directly evaluated share.");
+    }
+
+    try
+    {
+        *range.end();
+        throw std::logic_error("Failed: Expected out of range to be thrown.");
+    }
+    catch (const std::out_of_range &e) { /* Do nothing, test passed */ }
+
+    // The stored shares are the start of the same range
+    ShareRange stored = sss.getShareRange(1, sss.getNumShares());
+    if (std::vector<Share>(stored.begin(), stored.end()) != std::vector<Share>(sss.getShares()))
+        throw std::logic_error("Failed: Expected the range == the generated shares.");
+
+    ShareRange window = range.subrange(30, k);
+    uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret(std::vector<Share>(window.begin(), window.end()));
+    std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+    if (recoveredSecret != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+}
+
+
+void ShareFile_RecoversFromMappedShares_WhenWrittenAndOpened(int i) {
+    std::cout << "\nTEST #" << i << ": Shares written to a share file are recovered from the mapped file.\n";
+
+    uint64_t secret = 3141592653, n = 2000, k = 16;
+    ShamirsSecretSharing sss(secret, k);
+    sss.generateAdditionalShares(n);
+
+    std::string path = "shamir-test-shares.bin";
+    ShareFile::write(path, CompactShares(sss.getShares(), CompactShares::Layout::Packed61), k);
+    {
+        ShareFile file(path);
+        std::cout << "threshold: " << file.getThreshold() << " | firstX: " << file.getFirstX() << " | count: " << file.size() << '\n';
+        if (file.getLayout() != ShareFile::Layout::Range || file.getThreshold() != k || file.getFirstX() != 1 || file.size() != n)
+            throw std::logic_error("Failed: Expected the header to match the shares written.");
+        if (!file.verifyChecksum())
+            throw std::logic_error("Failed: Expected the checksum to match.");
+
+        uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret(file.getFirstX() + 700, file.getYValues() + 700, k);
+        std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+        if (recoveredSecret != secret)
+            throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+    }
+
+    // Every holder's column of a batch in its own file
+    std::vector<uint64_t> secrets = {11, 22, 33, 44, 55};
+    BatchDealer dealer(secrets, 3);
+    dealer.generateShares({5, 6, 7});
+    std::vector<ShareFile> files;
+    for (size_t h = 0; h < 3; h++)
+    {
+        std::string columnPath = "shamir-test-column-" + std::to_string(h) + ".bin";
+        ShareFile::write(columnPath, ShareFile::Layout::Column, 3, dealer.getXValues()[h], dealer.getColumn(h), secrets.size());
+        files.emplace_back(columnPath);
+        std::remove(columnPath.c_str());
+    }
+    std::vector<uint64_t> xValues;
+    std::vector<const uint64_t*> columns;
+    for (const ShareFile &file : files)
+    {
+        xValues.push_back(file.getFirstX());
+        columns.push_back(file.getYValues());
+    }
+    if (BatchDealer::recoverSecrets(xValues, columns, files[0].size()) != secrets)
+        throw std::logic_error("Failed: Expected every secret to be recovered from the mapped columns.");
+
+    // A flipped bit fails the checksum, and a bad magic number fails to open
+    std::fstream corrupt(path, std::ios::in | std::ios::out | std::ios::binary);
+    corrupt.seekp(ShareFile::headerBytes + 8 * 1234 + 3);
+    corrupt.put('\x5A');
+    corrupt.flush();
+    if (ShareFile(path).verifyChecksum())
+        throw std::logic_error("Failed: Expected the checksum not to match a corrupted file.");
+
+    corrupt.seekp(0);
+    corrupt.put('X');
+    corrupt.close();
+    try
+    {
+        ShareFile file(path);
+        throw std::logic_error("Failed: Expected invalid argument to be thrown.");
+    }
+    catch (const std::invalid_argument &e) { /* Do nothing, test passed */ }
+    std::remove(path.c_str());
+}
+
+
+void BulkProcessor_RecoversEverySecret_WhenSplitAndCombined(int i) {
+    std::cout << "\nTEST #" << i << ": Bulk split and combine round trip through text and share files.\n";
+
+    size_t numSecrets = BulkProcessor::chunkRecords + 1000;
+    std::stringstream secretsText;
+    for (size_t s = 0; s < numSecrets; s++)
+        secretsText << (s * 0x9E3779B97F4A7C15ULL) % sssPrime << (s % 3 == 0 ? " \r\n" : "\n");
+    std::string expected;
+    for (size_t s = 0; s < numSecrets; s++)
+        expected += std::to_string((s * 0x9E3779B97F4A7C15ULL) % sssPrime) + "\n";
+
+    BulkProcessor processor(3);
+    std::stringstream sharesText, recoveredText;
+    processor.split(secretsText, sharesText, 3, 5);
+    processor.combine(sharesText, recoveredText);
+    std::cout << "secrets: " << numSecrets << " | text round trip: " << (recoveredText.str() == expected) << '\n';
+    if (recoveredText.str() != expected)
+        throw std::logic_error("Failed: Expected every secret to be recovered from the share lines.");
+
+    secretsText.clear();
+    secretsText.seekg(0);
+    processor.splitToFiles(secretsText, "shamir-test-bulk", 3, 5);
+    std::stringstream recoveredFiles;
+    processor.combineFiles({"shamir-test-bulk.4", "shamir-test-bulk.1", "shamir-test-bulk.5"}, recoveredFiles);
+
+    // Fewer files than k, or files from splits with different thresholds, can't recover anything
+    secretsText.clear();
+    secretsText.seekg(0);
+    processor.splitToFiles(secretsText, "shamir-test-bulk-k2", 2, 2);
+
+    // As can a file with one bit flipped in a y-word, which its checksum catches
+    {
+        std::fstream corrupted("shamir-test-bulk.2", std::ios::in | std::ios::out | std::ios::binary);
+        corrupted.seekg(ShareFile::headerBytes + 8 * 100);
+        char byte = static_cast<char>(corrupted.get() ^ 0x04);
+        corrupted.seekp(ShareFile::headerBytes + 8 * 100);
+        corrupted.put(byte);
+    }
+
+    std::vector<std::vector<std::string>> badFileSets = {
+        {"shamir-test-bulk.4", "shamir-test-bulk.1"},
+        {"shamir-test-bulk-k2.1", "shamir-test-bulk-k2.2", "shamir-test-bulk.3"},
+        {"shamir-test-bulk.1", "shamir-test-bulk.2", "shamir-test-bulk.3"}
+    };
+    for (const std::vector<std::string> &badFiles : badFileSets)
+    {
+        try
+        {
+            std::stringstream ignoredFiles;
+            processor.combineFiles(badFiles, ignoredFiles);
+            throw std::logic_error("Failed: Expected invalid argument to be thrown.");
+        }
+        catch (const std::invalid_argument &e) { /* Do nothing, test passed */ }
+    }
+
+    for (int h = 1; h <= 5; h++)
+        std::remove(("shamir-test-bulk." + std::to_string(h)).c_str());
+    for (int h = 1; h <= 2; h++)
+        std::remove(("shamir-test-bulk-k2." + std::to_string(h)).c_str());
+    if (recoveredFiles.str() != expected)
+        throw std::logic_error("Failed: Expected every secret to be recovered from the share files.");
+
+    try
+    {
+        std::stringstream ignoredShares;
+        processor.split(secretsText, ignoredShares, 5, 3);
+        throw std::logic_error("Failed: Expected domain error to be thrown.");
+    }
+    catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+
+    // A bad threshold is refused before any share file is created
+    try
+    {
+        processor.splitToFiles(secretsText, "shamir-test-bulk-k1", 1, 3);
+        throw std::logic_error("Failed: Expected domain error to be thrown.");
+    }
+    catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+    if (std::ifstream("shamir-test-bulk-k1.1"))
+        throw std::logic_error("Failed: Expected no share file to be created for k = 1.");
+
+    std::stringstream badShares("1 2 3\n"), ignored;
+    try
+    {
+        processor.combine(badShares, ignored);
+        throw std::logic_error("Failed: Expected invalid argument to be thrown.");
+    }
+    catch (const std::invalid_argument &e) { /* Do nothing, test passed */ }
+}
+
+void CustodyServer_ServesBatchedRequests_WhenPipelined(int i) {
+    std::cout << "\nTEST #" << i << ": The custody daemon splits, recovers and refreshes over its socket.\n";
+
+    std::string path = "shamir-test-custody.sock";
+    CustodyServer server(path, 2);
+    std::thread loop(&CustodyServer::run, &server);
+
+    try
+    {
+        CustodyClient client(path);
+        uint64_t secret = 1234567890, k = 3, n = 5;
+        std::vector<Share> shares = client.split(secret, k, n);
+        uint64_t recoveredSecret = client.recover({shares[4], shares[0], shares[2]});
+        std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+        if (recoveredSecret != secret)
+            throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+
+        std::vector<Share> refreshed = client.refresh(shares, k);
+        if (refreshed == shares || client.recover({refreshed[1], refreshed[3], refreshed[4]}) != secret)
+            throw std::logic_error("Failed: Expected the refreshed shares to differ and recover the secret.");
+
+        // Pipelined requests are coalesced into batches, and a bad one fails alone
+        size_t numRequests = 500;
+        uint32_t firstId = 0;
+        for (size_t s = 0; s < numRequests; s++)
+        {
+            uint32_t id = client.send(CustodyProtocol::Opcode::Split, {s == 7 ? sssPrime : s, k, n});
+            firstId = s == 0 ? id : firstId;
+        }
+        std::vector<std::vector<uint64_t>> splits(numRequests);
+        for (size_t s = 0; s < numRequests; s++)
+        {
+            CustodyClient::Response response = client.receive();
+            size_t index = response.header.id - firstId;
+            splits[index] = response.words;
+            if ((index == 7) != (response.header.status == static_cast<uint16_t>(CustodyProtocol::Status::OutOfRange)))
+                throw std::logic_error("Failed: Expected only the too large secret to be rejected.");
+        }
+        std::vector<uint64_t> expectedSecrets(numRequests + firstId + 1);
+        for (size_t s = 0; s < numRequests; s++)
+        {
+            if (s == 7)
+                continue;
+            uint32_t id = client.send(CustodyProtocol::Opcode::Recover, {2, splits[s][1], 5, splits[s][4], 3, splits[s][2]});
+            expectedSecrets[id - numRequests] = s;
+        }
+        for (size_t s = 0; s + 1 < numRequests; s++)
+        {
+            CustodyClient::Response response = client.receive();
+            if (response.words.size() != 1 || response.words[0] != expectedSecrets[response.header.id - numRequests])
+                throw std::logic_error("Failed: Expected every pipelined secret to be recovered.");
+        }
+
+        try
+        {
+            client.recover({shares[0], shares[0], shares[1]});
+            throw std::logic_error("Failed: Expected invalid argument to be thrown.");
+        }
+        catch (const std::invalid_argument &e) { /* Do nothing, test passed */ }
+
+        // Pipelined refreshes with a huge k are each rejected, and the daemon keeps serving
+        size_t numRefreshes = 64;
+        for (size_t r = 0; r < numRefreshes; r++)
+            client.send(CustodyProtocol::Opcode::Refresh, {(1ULL << 60) + 1, 1, 5});
+        for (size_t r = 0; r < numRefreshes; r++)
+        {
+            if (client.receive().header.status != static_cast<uint16_t>(CustodyProtocol::Status::OutOfRange))
+                throw std::logic_error("Failed: Expected every out of range refresh to be rejected.");
+        }
+        if (client.recover({refreshed[0], refreshed[2], refreshed[4]}) != secret)
+            throw std::logic_error("Failed: Expected the daemon to keep serving after bad refreshes.");
+
+        // Recoveries and refreshes carrying more than maxShares pairs are refused like large splits
+        std::vector<uint64_t> oversized(2 * (CustodyProtocol::maxShares + 1));
+        for (size_t h = 0; h < oversized.size() / 2; h++)
+            oversized[2*h] = h + 1;
+        client.send(CustodyProtocol::Opcode::Recover, oversized);
+        oversized.insert(oversized.begin(), k);
+        client.send(CustodyProtocol::Opcode::Refresh, oversized);
+        for (int r = 0; r < 2; r++)
+        {
+            if (client.receive().header.status != static_cast<uint16_t>(CustodyProtocol::Status::OutOfRange))
+                throw std::logic_error("Failed: Expected every oversized request to be rejected.");
+        }
+
+        // Fewer shares than the threshold could never recover the secret
+        client.send(CustodyProtocol::Opcode::Split, {secret, 1000, 5});
+        if (client.receive().header.status != static_cast<uint16_t>(CustodyProtocol::Status::OutOfRange))
+            throw std::logic_error("Failed: Expected a split with n < k to be rejected.");
+
+        // Replies past CustodyServer::maxPendingOutput pause reading, and resume once they're read
+        size_t numLargeSplits = 40, largeN = CustodyProtocol::maxShares;
+        uint32_t firstLargeId = 0;
+        for (size_t s = 0; s < numLargeSplits; s++)
+        {
+            uint32_t id = client.send(CustodyProtocol::Opcode::Split, {s, k, largeN});
+            firstLargeId = s == 0 ? id : firstLargeId;
+        }
+        std::vector<bool> received(numLargeSplits);
+        for (size_t s = 0; s < numLargeSplits; s++)
+        {
+            CustodyClient::Response response = client.receive();
+            size_t index = response.header.id - firstLargeId;
+            if (index >= numLargeSplits || received[index] || response.words.size() != largeN)
+                throw std::logic_error("Failed: Expected every large split to be answered once.");
+            received[index] = true;
+        }
+    }
+    catch (...)
+    {
+        server.stop();
+        loop.join();
+        throw;
+    }
+
+    server.stop();
+    loop.join();
+}
+
+
+void RecoverSecretRobust_FindsFaultyShares_WhenSomeAreCorrupted(int i) {
+    std::cout << "\nTEST #" << i << ": recoverSecretRobust corrects up to (n-k)/2 corrupted shares.\n";
+
+    uint64_t secret = 2718281828, n = 31, k = 10;
+    std::cout << "secret = " << secret << " | n = " << n << " | k = " << k << '\n';
+
+    ShamirsSecretSharing sss(secret, k);
+    sss.generateAdditionalShares(n);
+    std::vector<Share> shares = sss.getShares();
+    std::swap(shares[3], shares[27]);
+
+    // Corrupt the maximum of (31-10)/2 = 10 shares
+    std::vector<uint64_t> faulty;
+    for (size_t s = 0; s < (n-k)/2; s++)
+    {
+        Share &share = shares[3*s];
+        share.second = Fp61::add(share.second, s+1);
+        faulty.push_back(share.first);
+    }
+    std::sort(faulty.begin(), faulty.end());
+
+    RobustRecovery result = ShamirsSecretSharing::recoverSecretRobust(shares, k);
+    std::cout << "recoveredSecret: " << result.secret << " | faulty shares: " << result.faultyXValues.size() << '\n';
+    if (result.secret != secret || result.faultyXValues != faulty)
+        throw std::logic_error("Failed: Expected the secret and the corrupted x-values to be found.");
+
+    // One more corrupted share is beyond the decoding radius
+    shares[1].second = Fp61::add(shares[1].second, 1);
+    try
+    {
+        ShamirsSecretSharing::recoverSecretRobust(shares, k);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        return;
+    }
+    throw std::logic_error("Failed: Expected an exception when too many shares are corrupted.");
+}
+
+
+void Polynomial_FastInterpolation_MatchesDirectWeights(int i) {
+    std::cout << "\nTEST #" << i << ": Subproduct tree interpolation agrees with the direct Lagrange weights.\n";
+
+    // Karatsuba against the schoolbook product, across the threshold
+    std::vector<uint64_t> a(150), b(97);
+    for (size_t j = 0; j < a.size(); j++)
+        a[j] = (j * 0x9E3779B97F4A7C15ULL + 3) % sssPrime;
+    for (size_t j = 0; j < b.size(); j++)
+        b[j] = (j * 0xC2B2AE3D27D4EB4FULL + 1) % sssPrime;
+
+    std::vector<uint64_t> expected(a.size() + b.size() - 1, 0);
+    for (size_t x = 0; x < a.size(); x++)
+        for (size_t y = 0; y < b.size(); y++)
+            expected[x+y] = Fp61::add(expected[x+y], Fp61::mul(a[x], b[y]));
+    if (Polynomial::multiply(a, b) != expected)
+        throw std::logic_error("Failed: Expected the Karatsuba product == the schoolbook product.");
+
+    // a = qb + r
+    Polynomial::Coefficients quotient, remainder;
+    Polynomial::divide(a, b, quotient, remainder);
+    std::vector<uint64_t> check = Polynomial::multiply(quotient, b);
+    check.resize(a.size(), 0);
+    for (size_t j = 0; j < remainder.size(); j++)
+        check[j] = Fp61::add(check[j], remainder[j]);
+    if (check != a || remainder.size() >= b.size())
+        throw std::logic_error("Failed: Expected quotient * divisor + remainder == dividend.");
+
+    std::vector<uint64_t> xValues;
+    for (uint64_t x = 0; x < 300; x++)
+        xValues.push_back((x * x * 7919 + x + 1) % sssPrime);
+    std::vector<uint64_t> direct = Lagrange::weightsAtZero(xValues);
+    std::vector<uint64_t> fast = Lagrange::weightsAtZeroFast(xValues);
+    std::cout << "k: " << xValues.size() << " | first weight: " << fast[0] << " | direct: " << direct[0] << '\n';
+    if (fast != direct)
+        throw std::logic_error("Failed: Expected the subproduct tree weights == the direct weights.");
+}
+
+
+void RecoveryPlan_RecoversManySecrets_WhenHoldersAreFixed(int i) {
+    std::cout << "\nTEST #" << i << ": A recovery plan recovers many secrets shared among the same holders.\n";
+
+    uint64_t n = 7, k = 5;
+    std::vector<uint64_t> holders = {2, 3, 5, 6, 7};
+    std::cout << "n = " << n << " | k = " << k << '\n';
+
+    RecoveryPlan plan(holders);
+    for (uint64_t secret = 1000; secret < 1010; secret++)
+    {
+        ShamirsSecretSharing sss(secret, k);
+        sss.generateAdditionalShares(n);
+        std::vector<Share> shares = sss.getShares();
+
+        std::vector<uint64_t> yValues;
+        for (uint64_t x : holders)
+            yValues.push_back(shares[x-1].second);
+
+        uint64_t recoveredSecret = plan.recover(yValues);
+        std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+        if (recoveredSecret != secret)
+            throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+    }
+
+    // A y-value of p or more would overflow the accumulator, so it's refused
+    try
+    {
+        plan.recover(std::vector<uint64_t>(k, ~0ULL));
+        throw std::logic_error("Failed: Expected domain error to be thrown.");
+    }
+    catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+}
+
+
+void RecoveryPlanCache_EvictsLeastRecentlyUsed_WhenFull(int i) {
+    std::cout << "\nTEST #" << i << ": The recovery plan cache reuses plans and evicts the least recently used one.\n";
+
+    RecoveryPlanCache cache(2);
+    auto first = cache.get({1, 2, 3});
+    auto second = cache.get({4, 5, 6});
+
+    if (cache.get({1, 2, 3}) != first)
+        throw std::logic_error("Failed: Expected the cached plan to be reused.");
+
+    // {4, 5, 6} is now the least recently used plan
+    cache.get({7, 8, 9});
+    std::cout << "Cache size: " << cache.size() << '\n';
+    if (cache.size() != 2)
+        throw std::logic_error("Failed: Expected the cache size to stay at its capacity.");
+    if (cache.get({1, 2, 3}) != first)
+        throw std::logic_error("Failed: Expected the recently used plan to survive eviction.");
+    if (cache.get({4, 5, 6}) == second)
+        throw std::logic_error("Failed: Expected the least recently used plan to be evicted.");
+
+    // Plans are also evicted to stay within the share limit, and one over it isn't kept
+    RecoveryPlanCache bounded(8, 7);
+    auto small = bounded.get({1, 2, 3});
+    bounded.get({4, 5, 6, 7});
+    if (bounded.size() != 2 || bounded.get({1, 2, 3}) != small)
+        throw std::logic_error("Failed: Expected both plans to fit within 7 shares.");
+    bounded.get({8, 9});
+    if (bounded.size() != 2 || bounded.get({1, 2, 3}) != small)
+        throw std::logic_error("Failed: Expected the least recently used plan to be evicted for the share limit.");
+    auto large = bounded.get({1, 2, 3, 4, 5, 6, 7, 8});
+    if (bounded.size() != 2 || bounded.get({1, 2, 3, 4, 5, 6, 7, 8}) == large)
+        throw std::logic_error("Failed: Expected a plan over the share limit not to be cached.");
+}
+
+
+void BatchDealer_RecoversEverySecret_WhenKColumnsCombined(int i) {
+    std::cout << "\nTEST #" << i << ": A batch dealer splits many secrets and any k holders recover all of them.\n";
+
+    uint64_t numSecrets = 1000, k = 4;
+    std::cout << "numSecrets = " << numSecrets << " | k = " << k << '\n';
+
+    std::vector<uint64_t> secrets(numSecrets);
+    for (uint64_t s = 0; s < numSecrets; s++)
+        secrets[s] = (s * 0x9E3779B97F4A7C15ULL) % sssPrime;
+
+    BatchDealer dealer(secrets, k);
+    dealer.generateShares({1, 2, 3});
+    dealer.generateShares({10, 20, 30});
+
+    std::vector<uint64_t> xValues = {2, 10, 3, 30};
+    std::vector<const uint64_t*> columns = {dealer.getColumn(1), dealer.getColumn(3), dealer.getColumn(2), dealer.getColumn(5)};
+    std::vector<uint64_t> recovered = BatchDealer::recoverSecrets(xValues, columns, numSecrets);
+    if (recovered != secrets)
+        throw std::logic_error("Failed: Expected every recovered secret == secret.");
+
+    // A single secret's shares are ordinary shares
+    uint64_t s = 123;
+    uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret({{1, dealer.getColumn(0)[s]}, {20, dealer.getColumn(4)[s]}, 
+        {30, dealer.getColumn(5)[s]}, {3, dealer.getColumn(2)[s]}});
+    std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secrets[s] << '\n';
+    if (recoveredSecret != secrets[s])
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+
+    try 
+    {
+        dealer.generateShares({7, 20});
+        throw std::logic_error("Failed: Expected invalid argument to be thrown.");
+    } 
+    catch (const std::invalid_argument &e) { /* Do nothing, test passed */ }
+
+    // k * numSecrets would wrap around and size the coefficients too small
+    try 
+    {
+        BatchDealer overflowing(std::vector<uint64_t>(16, 1), (1ULL << 60) + 1);
+        throw std::logic_error("Failed: Expected domain error to be thrown.");
+    } 
+    catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+}
+
+
+void RefreshShares_KeepsSecret_WhenSharesAreRefreshed(int i) {
+    std::cout << "\nTEST #" << i << ": Refreshed shares recover the same secret and replace the old shares.\n";
+
+    uint64_t secret = 1414213562, n = 6, k = 3;
+    ShamirsSecretSharing sss(secret, k);
+    sss.generateAdditionalShares(n);
+    std::vector<Share> oldShares = sss.getShares();
+    std::vector<Share> newShares = oldShares;
+    ShamirsSecretSharing::refreshShares(newShares, k);
+
+    uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret({newShares[5], newShares[0], newShares[3]});
+    std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+    if (recoveredSecret != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret after a refresh.");
+    if (newShares == oldShares)
+        throw std::logic_error("Failed: Expected the refreshed shares to change.");
+    if (ShamirsSecretSharing::recoverSecret({oldShares[5], newShares[0], newShares[3]}) == secret)
+        throw std::logic_error("Failed: Expected old and new shares not to combine.");
+
+    // Every secret in a batch, refreshed twice
+    uint64_t numSecrets = 500;
+    std::vector<uint64_t> secrets(numSecrets);
+    for (uint64_t s = 0; s < numSecrets; s++)
+        secrets[s] = (s * 0xC2B2AE3D27D4EB4FULL) % sssPrime;
+
+    BatchDealer dealer(secrets, k);
+    dealer.generateShares({4, 9, 16, 25});
+    std::vector<std::vector<uint64_t>> columns;
+    std::vector<uint64_t*> pointers;
+    for (size_t h = 0; h < dealer.getXValues().size(); h++)
+        columns.emplace_back(dealer.getColumn(h), dealer.getColumn(h) + numSecrets);
+    for (auto &column : columns)
+        pointers.push_back(column.data());
+
+    BatchDealer::refreshShares(dealer.getXValues(), pointers, numSecrets, k);
+    BatchDealer::refreshShares(dealer.getXValues(), pointers, numSecrets, k);
+    if (columns[2] == std::vector<uint64_t>(dealer.getColumn(2), dealer.getColumn(2) + numSecrets))
+        throw std::logic_error("Failed: Expected the refreshed column to change.");
+
+    std::vector<uint64_t> recovered = BatchDealer::recoverSecrets({25, 4, 16}, {pointers[3], pointers[0], pointers[2]}, numSecrets);
+    if (recovered != secrets)
+        throw std::logic_error("Failed: Expected every secret to be recovered after a refresh.");
+
+    // One bad share in the last column leaves every column untouched
+    std::vector<std::vector<uint64_t>> before = columns;
+    columns[3][numSecrets-1] = sssPrime;
+    before[3][numSecrets-1] = sssPrime;
+    try 
+    {
+        BatchDealer::refreshShares(dealer.getXValues(), pointers, numSecrets, k);
+        throw std::logic_error("Failed: Expected domain error to be thrown.");
+    } 
+    catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+    if (columns != before)
+        throw std::logic_error("Failed: Expected a failed refresh to leave the shares unchanged.");
+
+    try 
+    {
+        BatchDealer::refreshShares(dealer.getXValues(), pointers, 16, (1ULL << 60) + 1);
+        throw std::logic_error("Failed: Expected domain error to be thrown.");
+    } 
+    catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+}
+
+
+void testShareStreamRoundTrip(size_t length) {
+    uint64_t n = 5, k = 3;
+    std::string secret(length, '\0');
+    for (size_t b = 0; b < length; b++)
+        secret[b] = static_cast<char>((b * 131 + 7) & 0xFF);
+
+    std::vector<std::stringstream> holderStreams(n);
+    std::vector<std::ostream*> outputs;
+    for (auto &stream : holderStreams)
+        outputs.push_back(&stream);
+
+    std::istringstream input(secret);
+    ShareStream::split(input, outputs, k);
+
+    // Combine holders #4, #1 and #5
+    std::vector<std::istream*> inputs = {&holderStreams[3], &holderStreams[0], &holderStreams[4]};
+    std::ostringstream output;
+    ShareStream::combine(inputs, output);
+
+    std::cout << "length: " << length << " | recovered length: " << output.str().size() << '\n';
+    if (output.str() != secret)
+        throw std::logic_error("Failed: Expected the recovered bytes == secret bytes.");
+}
+
+
+void ShareStream_RecoversBytes_WhenSecretSpansManyBlocks(int i) {
+    std::cout << "\nTEST #" << i << ": Share streams split and combine byte secrets of any length.\n";
+
+    size_t blockBytes = ShareStream::blockLimbs * ShareStream::limbBytes;
+    for (size_t length : {size_t(0), size_t(1), size_t(7), size_t(8), blockBytes - 1, blockBytes, 2*blockBytes + 13})
+        testShareStreamRoundTrip(length);
+
+    // Fewer holders than k could never combine, so nothing is written to them
+    std::vector<std::stringstream> holderStreams(2);
+    std::vector<std::ostream*> outputs = {&holderStreams[0], &holderStreams[1]};
+    for (uint64_t k : {uint64_t(1), uint64_t(3)})
+    {
+        std::istringstream input("secret");
+        try
+        {
+            ShareStream::split(input, outputs, k);
+            throw std::logic_error("Failed: Expected domain error to be thrown.");
+        }
+        catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+    }
+    if (!holderStreams[0].str().empty() || !holderStreams[1].str().empty())
+        throw std::logic_error("Failed: Expected a rejected split to write nothing.");
+}
+
+
+void GF256_RecoversBytes_WithEveryKernel(int i) {
+    std::cout << "\nTEST #" << i << ": GF(2^8) sharing recovers byte secrets with every supported kernel.\n";
+
+    uint64_t n = 6, k = 4;
+    std::vector<uint8_t> secret(1000 + 13);
+    for (size_t b = 0; b < secret.size(); b++)
+        secret[b] = static_cast<uint8_t>(b * 73 + 5);
+
+    GF256SecretSharing::Kernel original = GF256SecretSharing::getKernel();
+    std::vector<GF256SecretSharing::Kernel> kernels = {GF256SecretSharing::Kernel::Scalar, GF256SecretSharing::Kernel::SSSE3, GF256SecretSharing::Kernel::AVX2};
+    for (GF256SecretSharing::Kernel splitKernel : kernels)
+    {
+        if (!GF256SecretSharing::setKernel(splitKernel))
+            continue;
+        GF256SecretSharing sss(secret, k);
+        sss.generateAdditionalShares(n);
+        std::vector<ByteShare> shares = sss.getShares();
+
+        for (GF256SecretSharing::Kernel recoverKernel : kernels)
+        {
+            if (!GF256SecretSharing::setKernel(recoverKernel))
+                continue;
+            std::cout << "split kernel: " << int(splitKernel) << " | recover kernel: " << int(recoverKernel) << '\n';
+
+            if (GF256SecretSharing::recoverSecret({shares[5], shares[1], shares[3], shares[2]}) != secret)
+                throw std::logic_error("Failed: Expected the recovered bytes == secret bytes.");
+            if (GF256SecretSharing::recoverSecret({shares[0], shares[1], shares[2]}) == secret)
+                throw std::logic_error("Failed: Expected the recovered bytes != secret bytes with fewer than k shares.");
+        }
+    }
+    GF256SecretSharing::setKernel(original);
+
+    try 
+    {
+        GF256SecretSharing sss(secret, k);
+        sss.generateAdditionalShares(256);
+        throw std::logic_error("Failed: Expected domain error to be thrown.");
+    } 
+    catch (const std::domain_error &e) { /* Do nothing, test passed */ }
+}
+
+
 void GenerateAdditionalShares_GeneratesMoreShares_WhenCalledMultipleTimes(int i) {
     std::cout << "\nTEST #" << i << ": generateAdditionalShares will generate additional shares when called multiple times.\n";
     
@@ -143,6 +1114,145 @@ void RecoverSecret_ThrowsInvalidArgument_WhenXValuesNotUnique(int i) {
 }
 
 
+void GenerateAdditionalShares_MatchesSerial_WhenUsingThreads(int i) {
+    std::cout << "\nTEST #" << i << ": generateAdditionalShares gives the same shares with several threads.\n";
+
+    uint64_t secret = 987654321, k = 50;
+    ShamirsSecretSharing serial(secret, k);
+    ShamirsSecretSharing parallel = serial;
+    parallel.setNumThreads(4);
+    std::cout << "threads = " << parallel.getNumThreads() << '\n';
+
+    for (uint64_t n : {1, 3, 1000, 37})
+    {
+        serial.generateAdditionalShares(n);
+        parallel.generateAdditionalShares(n);
+    }
+
+    std::cout << "Number of shares: " << parallel.getNumShares() << '\n';
+    if (serial.getShares() != parallel.getShares())
+        throw std::logic_error("Failed: Expected the threaded shares == the serial shares.");
+}
+
+
+void GenerateAdditionalShares_ContinuesDifferenceTable_WhenExtended(int i) {
+    std::cout << "\nTEST #" << i << ": Shares from the difference table lie on the same polynomial as directly evaluated shares.\n";
+
+    uint64_t secret = 31415926535, k = 6;
+    ShamirsSecretSharing sss(secret, k);
+
+    // 3 shares are evaluated directly, then 500 and 2 more come from one difference table
+    sss.generateAdditionalShares(3);
+    sss.generateAdditionalShares(500);
+    sss.generateAdditionalShares(2);
+    std::vector<Share> shares = sss.getShares();
+
+    for (size_t first : {0, 1, 2, 3, 250, 499})
+    {
+        std::vector<Share> subset(shares.begin() + first, shares.begin() + first + k);
+        uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret(subset);
+        std::cout << "first x: " << subset[0].first << " | recoveredSecret: " << recoveredSecret << '\n';
+        if (recoveredSecret != secret)
+            throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+    }
+}
+
+
+void PolynomialEvaluator_MatchesScalar_WithEveryKernel(int i) {
+    std::cout << "\nTEST #" << i << ": Every polynomial evaluator kernel agrees with the scalar kernel.\n";
+
+    std::vector<uint64_t> coefficients = {sssPrime-1, 5, sssPrime-2, 0, 1ULL << 60, 123456789, sssPrime-1};
+    std::vector<uint64_t> xValues;
+    for (uint64_t x = 0; x < 37; x++)
+        xValues.push_back(x < 20 ? x : sssPrime - x);
+
+    PolynomialEvaluator::Kernel original = PolynomialEvaluator::getKernel();
+    PolynomialEvaluator::setKernel(PolynomialEvaluator::Kernel::Scalar);
+    std::vector<uint64_t> expected(xValues.size());
+    PolynomialEvaluator::evaluate(coefficients.data(), coefficients.size(), xValues.data(), expected.data(), xValues.size());
+
+    for (PolynomialEvaluator::Kernel kernel : {PolynomialEvaluator::Kernel::AVX2, PolynomialEvaluator::Kernel::AVX512})
+    {
+        if (!PolynomialEvaluator::setKernel(kernel))
+            continue;
+        std::cout << "kernel: " << int(kernel) << '\n';
+
+        std::vector<uint64_t> yValues(xValues.size());
+        PolynomialEvaluator::evaluate(coefficients.data(), coefficients.size(), xValues.data(), yValues.data(), xValues.size());
+        if (yValues != expected)
+            throw std::logic_error("Failed: Expected the SIMD kernel's y-values == the scalar kernel's y-values.");
+    }
+    PolynomialEvaluator::setKernel(original);
+
+    // Shares issued at arbitrary x-values lie on the same polynomial
+    uint64_t secret = 2718281828, k = 5;
+    ShamirsSecretSharing sss(secret, k);
+    std::vector<Share> shares = sss.getSharesAt({1000000007, 3, sssPrime-1, 77, 1ULL << 40});
+    uint64_t recoveredSecret = ShamirsSecretSharing::recoverSecret(shares);
+    std::cout << "recoveredSecret: " << recoveredSecret << " | secret: " << secret << '\n';
+    if (recoveredSecret != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+}
+
+
+void ChaCha20Rng_MatchesRfc8439_WithEveryKernel(int i) {
+    std::cout << "\nTEST #" << i << ": ChaCha20 matches the RFC 8439 block and every kernel agrees with the scalar kernel.\n";
+
+    // RFC 8439 section 2.3.2: key 00 01 ... 1f, block counter 1, nonce 00:00:00:09:00:00:00:4a:00:00:00:00
+    std::array<uint32_t, 8> key;
+    for (uint32_t w = 0; w < 8; w++)
+        key[w] = (4*w) | (4*w+1) << 8 | (4*w+2) << 16 | (4*w+3) << 24;
+    uint64_t counter = 1 | 0x09000000ULL << 32, nonce = 0x4a000000;
+    std::vector<uint64_t> rfcBlock = {0x15593bd1e4e7f110ULL, 0xc47120a31fdd0f50ULL, 0x0368c033c7f4d1c7ULL, 
+        0x4e6cd4c39aaa2204ULL, 0x09aa9f07466482d2ULL, 0xa2028bd905d7c214ULL, 0xb94e16ded19c12b5ULL, 0x4e3c50a2e883d0cbULL};
+
+    // Enough blocks for whole AVX-512 groups and a scalar remainder
+    ChaCha20Rng::Kernel original = ChaCha20Rng::getKernel();
+    ChaCha20Rng::setKernel(ChaCha20Rng::Kernel::Scalar);
+    std::vector<uint64_t> expected(8 * 37);
+    ChaCha20Rng(key, nonce, counter).fill(expected.data(), expected.size());
+    if (!std::equal(rfcBlock.begin(), rfcBlock.end(), expected.begin()))
+        throw std::logic_error("Failed: Expected the first block == the RFC 8439 test vector.");
+
+    for (ChaCha20Rng::Kernel kernel : {ChaCha20Rng::Kernel::AVX2, ChaCha20Rng::Kernel::AVX512})
+    {
+        if (!ChaCha20Rng::setKernel(kernel))
+            continue;
+        std::cout << "kernel: " << int(kernel) << '\n';
+
+        // Small and large requests, so both the buffer and direct generation are used
+        ChaCha20Rng rng(key, nonce, counter);
+        std::vector<uint64_t> words(expected.size());
+        rng.fill(words.data(), 3);
+        rng.fill(words.data() + 3, 200);
+        rng.fill(words.data() + 203, words.size() - 203);
+        if (words != expected)
+            throw std::logic_error("Failed: Expected the SIMD kernel's keystream == the scalar kernel's keystream.");
+    }
+    ChaCha20Rng::setKernel(original);
+
+    // Field elements are in range, and the leading coefficients are non-zero
+    ChaCha20Rng rng;
+    std::vector<uint64_t> values(100000);
+    rng.fillFieldElements(values.data(), values.size(), 1);
+    for (uint64_t value : values)
+    {
+        if (value < 1 || value > sssPrime-1)
+            throw std::logic_error("Failed: Expected every field element in [1, p).");
+    }
+
+    // A fixed source makes the dealer reproducible
+    auto first = std::make_shared<ChaCha20Rng>(key, nonce), second = std::make_shared<ChaCha20Rng>(key, nonce);
+    ShamirsSecretSharing a(42, 4, first), b(42, 4, second);
+    a.generateAdditionalShares(6);
+    b.generateAdditionalShares(6);
+    if (a.getShares() != b.getShares())
+        throw std::logic_error("Failed: Expected the same shares from the same random source.");
+    if (ShamirsSecretSharing::recoverSecret(std::vector<Share>(a.getShares())) != 42)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+}
+
+
 void GenerateAdditionalShares_XValues_AreUnique1ToN(int i) {
     std::cout << "\nTEST #" << i << ": generateAdditionalShares will create unique points.\n";
     
@@ -198,6 +1308,184 @@ void GenerateAdditionalShares_ThrowsDomainError_WhenNIsTooLarge(int i) {
 }
 
 
+void Fp61_MatchesGenericModulo_WhenOperandsAreAtTheEdges(int i) {
+    std::cout << "\nTEST #" << i << ": Fp61 arithmetic agrees with the generic % reduction.\n";
+
+    std::vector<uint64_t> values = {0, 1, 2, 3, sssPrime-1, sssPrime-2, sssPrime/2, (1ULL << 32) + 7, 1234567890123456789ULL % sssPrime};
+    for (uint64_t a : values)
+    {
+        for (uint64_t b : values)
+        {
+            if (Fp61::mul(a, b) != static_cast<uint64_t>((__uint128_t(a) * b) % sssPrime))
+                throw std::logic_error("Failed: Expected Fp61::mul to match (a*b) % p.");
+            if (Fp61::add(a, b) != (a + b) % sssPrime)
+                throw std::logic_error("Failed: Expected Fp61::add to match (a+b) % p.");
+            if (Fp61::sub(a, b) != (a + sssPrime - b) % sssPrime)
+                throw std::logic_error("Failed: Expected Fp61::sub to match (a-b) % p.");
+        }
+
+        if (Fp61::reduce(uint64_t(~0ULL - a)) != (~0ULL - a) % sssPrime)
+            throw std::logic_error("Failed: Expected 64-bit Fp61::reduce to match % p.");
+        __uint128_t wide = (__uint128_t(~0ULL - a) << 64) | a;
+        if (Fp61::reduce(wide) != static_cast<uint64_t>(wide % sssPrime))
+            throw std::logic_error("Failed: Expected 128-bit Fp61::reduce to match % p.");
+        if (a != 0 && Fp61::mul(a, Fp61::inv(a)) != 1)
+            throw std::logic_error("Failed: Expected a * a^{-1} == 1.");
+    }
+
+    Fp61::Accumulator acc;
+    uint64_t expected = 0;
+    for (uint64_t j = 0; j < 1000; j++)
+    {
+        acc.addProduct(sssPrime-1-j, sssPrime-2);
+        expected = static_cast<uint64_t>((expected + __uint128_t(sssPrime-1-j) * (sssPrime-2)) % sssPrime);
+    }
+    std::cout << "accumulated: " << acc.value() << " | expected: " << expected << '\n';
+    if (acc.value() != expected)
+        throw std::logic_error("Failed: Expected the lazy accumulator to match the reduced sum.");
+}
+
+
+template <typename Field>
+void testFieldRoundTrip(typename Field::Element secret, uint64_t k) {
+    SecretSharing<Field> sss(secret, k);
+    sss.generateAdditionalShares(k + 4);
+    std::vector<typename SecretSharing<Field>::Share> shares = sss.getShares();
+
+    // Any k shares, in any order
+    std::vector<typename SecretSharing<Field>::Share> userShares(shares.rbegin(), shares.rbegin() + k);
+    if (SecretSharing<Field>::recoverSecret(userShares) != secret)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+
+    userShares.back() = userShares.front();
+    try {
+        SecretSharing<Field>::recoverSecret(userShares);
+    } catch (const std::invalid_argument &e) {
+        return;
+    }
+    throw std::logic_error("Failed: Expected a repeated x-value to throw std::invalid_argument.");
+}
+
+
+// Fp61's policy members, through the generic template rather than the specialization
+struct Fp61Policy : Fp61 {};
+
+
+// Multiplies by doubling and adding, only using Fp127::add
+__uint128_t slowMultiply127(__uint128_t a, __uint128_t b) {
+    __uint128_t result = 0;
+    for (int bit = 126; bit >= 0; bit--)
+    {
+        result = Fp127::add(result, result);
+        if ((b >> bit) & 1)
+            result = Fp127::add(result, a);
+    }
+    return result;
+}
+
+
+void SecretSharing_RecoversSecret_WithEveryField(int i) {
+    std::cout << "\nTEST #" << i << ": SecretSharing recovers the secret over 2^61-1, 2^127-1 and Montgomery fields.\n";
+
+    // The 256-bit product and its Mersenne folding, at the edges
+    const __uint128_t p127 = Fp127::p;
+    std::vector<__uint128_t> values = {0, 1, 2, p127-1, p127-2, p127/2, __uint128_t(1) << 126, 
+        (__uint128_t(0x0123456789ABCDEFULL) << 64) | 0xFEDCBA9876543210ULL, __uint128_t(~0ULL)};
+    for (__uint128_t a : values)
+    {
+        for (__uint128_t b : values)
+        {
+            if (Fp127::mul(a, b) != slowMultiply127(a, b))
+                throw std::logic_error("Failed: Expected Fp127::mul to match repeated doubling.");
+        }
+        if (a != 0 && Fp127::mul(a, Fp127::inv(a)) != 1)
+            throw std::logic_error("Failed: Expected a * a^{-1} == 1 in Fp127.");
+    }
+
+    // Montgomery form over 2^61-1 agrees with the Mersenne reduction
+    using Montgomery61 = MontgomeryField<sssPrime>;
+    std::vector<uint64_t> small = {0, 1, 2, sssPrime-1, sssPrime-2, sssPrime/2, 1234567890123456789ULL % sssPrime};
+    for (uint64_t a : small)
+    {
+        for (uint64_t b : small)
+        {
+            uint64_t product = Montgomery61::decode(Montgomery61::mul(Montgomery61::encode(a), Montgomery61::encode(b)));
+            if (product != Fp61::mul(a, b))
+                throw std::logic_error("Failed: Expected the Montgomery product to match Fp61::mul.");
+        }
+        if (a != 0 && Montgomery61::decode(Montgomery61::inv(Montgomery61::encode(a))) != Fp61::inv(a))
+            throw std::logic_error("Failed: Expected the Montgomery inverse to match Fp61::inv.");
+    }
+
+    __uint128_t secret127 = (__uint128_t(0x7EDCBA9876543210ULL) << 64) | 0x0F1E2D3C4B5A6978ULL;
+    testFieldRoundTrip<Fp127>(secret127, 7);
+    testFieldRoundTrip<Fp61>(1234567890123456789ULL, 7);
+    testFieldRoundTrip<Fp61Policy>(1234567890123456789ULL, 7);
+    testFieldRoundTrip<MontgomeryField<65537>>(65536, 5);
+    testFieldRoundTrip<MontgomeryField<(1ULL << 63) - 25>>((1ULL << 63) - 26, 9);
+
+    std::cout << "recovered a 127-bit secret, top word: " << std::hex << uint64_t(secret127 >> 64) << std::dec << '\n';
+
+    try
+    {
+        SecretSharing127::recoverSecret({});
+        throw std::logic_error("Failed: Expected invalid argument to be thrown.");
+    }
+    catch (const std::invalid_argument &e) { /* Do nothing, test passed */ }
+
+    try {
+        SecretSharing127 tooLarge(p127, 3);
+    } catch (const std::domain_error &e) {
+        return;
+    }
+    throw std::logic_error("Failed: Expected a secret of p to throw std::domain_error.");
+}
+
+
+void Stats_CountsHotPaths_WhenCompiledIn(int i) {
+    std::cout << "\nTEST #" << i << ": Stats counts the hot paths with -DSSS_STATS, and nothing without it.\n";
+
+    Stats::Snapshot before = Stats::snapshot();
+
+    ShamirsSecretSharing sss(123456789, 5);
+    sss.generateAdditionalShares(20);
+    std::vector<Share> shares = sss.getSharesAt({3, 17, 29, 31, 8});
+    RecoveryPlanCache::global().clear();
+    if (ShamirsSecretSharing::recoverSecret(shares) != 123456789)
+        throw std::logic_error("Failed: Expected recoveredSecret == secret.");
+
+    // Counts from a thread that has exited are kept
+    std::thread worker([] { volatile uint64_t inverse = Fp61::inv(12345); (void)inverse; });
+    worker.join();
+
+    Stats::Snapshot delta = Stats::snapshot() - before;
+    std::cout << "multiplications: " << delta.get(Stats::Counter::Multiplications) 
+        << " | allocations: " << delta.get(Stats::Counter::Allocations) << '\n';
+
+    if (!Stats::enabled)
+    {
+        for (size_t c = 0; c < Stats::numCounters; c++)
+        {
+            if (delta.counters[c] != 0)
+                throw std::logic_error("Failed: Expected no counts without SSS_STATS.");
+        }
+        return;
+    }
+
+    if (delta.get(Stats::Counter::SharesGenerated) != 20)
+        throw std::logic_error("Failed: Expected 20 shares to be counted.");
+    if (delta.get(Stats::Counter::Multiplications) == 0 || delta.get(Stats::Counter::BatchInversions) == 0)
+        throw std::logic_error("Failed: Expected the recovery's multiplications and batch inversion to be counted.");
+    if (delta.get(Stats::Counter::Inversions) < 2 || delta.get(Stats::Counter::Allocations) == 0)
+        throw std::logic_error("Failed: Expected the worker's inversion and the allocations to be counted.");
+
+    size_t recover = static_cast<size_t>(Stats::Timer::RecoverSecret);
+    size_t generate = static_cast<size_t>(Stats::Timer::GenerateAdditionalShares);
+    if (delta.timerCalls[recover] != 1 || delta.timerCalls[generate] != 1 || delta.timerNanoseconds[recover] == 0)
+        throw std::logic_error("Failed: Expected one timed call each to recoverSecret and generateAdditionalShares.");
+}
+
+
 void testConstructorThrowsError(uint64_t secret, uint64_t k) {
     try {
         ShamirsSecretSharing sss(secret, k);
@@ -240,14 +1528,39 @@ int main() {
         RecoverSecret_IsSuccessful_WhenKShares,
         RecoverSecret_IsUnsuccessful_WhenFewerThanKShares,
         RecoverSecret_IsSuccessful_WhenLargeK,
+        RecoverSecret_MatchesSerial_WhenUsingRecoveryThreads,
+        IncrementalRecovery_MatchesRecoverSecret_WhenSharesArriveAndLeave,
+        EnrollShares_MatchesDealerShares_WhenDealerIsGone,
+        RecoverSecret_IsSuccessful_WhenSharesAreOutOfOrder,
+        RecoverSecret_IsSuccessful_WhenXValuesAreEvenlySpaced,
+        RecoverSecretRobust_FindsFaultyShares_WhenSomeAreCorrupted,
+        CompactShares_RecoversSecret_WhenPacked,
+        ShareRange_MatchesDirectShares_WhenReadInAnyOrder,
+        ShareFile_RecoversFromMappedShares_WhenWrittenAndOpened,
+        BulkProcessor_RecoversEverySecret_WhenSplitAndCombined,
+        CustodyServer_ServesBatchedRequests_WhenPipelined,
+        Polynomial_FastInterpolation_MatchesDirectWeights,
+        RecoveryPlan_RecoversManySecrets_WhenHoldersAreFixed,
+        RecoveryPlanCache_EvictsLeastRecentlyUsed_WhenFull,
+        BatchDealer_RecoversEverySecret_WhenKColumnsCombined,
+        RefreshShares_KeepsSecret_WhenSharesAreRefreshed,
+        ShareStream_RecoversBytes_WhenSecretSpansManyBlocks,
+        GF256_RecoversBytes_WithEveryKernel,
         RecoverSecret_ThrowsDomainError_WhenShareIsTooLarge,
         RecoverSecret_ThrowsDomainError_WhenShareIsTheSecret,
         RecoverSecret_ThrowsInvalidArgument_WhenXValuesNotUnique,
         GenerateAdditionalShares_GeneratesMoreShares_WhenCalledMultipleTimes,
+        GenerateAdditionalShares_MatchesSerial_WhenUsingThreads,
+        GenerateAdditionalShares_ContinuesDifferenceTable_WhenExtended,
+        PolynomialEvaluator_MatchesScalar_WithEveryKernel,
+        ChaCha20Rng_MatchesRfc8439_WithEveryKernel,
         GenerateAdditionalShares_XValues_AreUnique1ToN,
         GenerateAdditionalShares_ThrowsDomainError_WhenNIsTooLarge,
         Constructor_ThrowsDomainError_WhenSecretIsLargerThanP,
-        Constructor_ThrowsDomainError_WhenKIsOutOfDomain
+        Constructor_ThrowsDomainError_WhenKIsOutOfDomain,
+        Fp61_MatchesGenericModulo_WhenOperandsAreAtTheEdges,
+        SecretSharing_RecoversSecret_WithEveryField,
+        Stats_CountsHotPaths_WhenCompiledIn
     };
 
     int passed = 0, failed = 0;
@@ -1,42 +1,82 @@
 #ifndef SHAMIRS_SECRET_SHARING_H
 #define SHAMIRS_SECRET_SHARING_H
 
+#include "compact-shares.h"
+#include "difference-table.h"
+#include "fp61.h"
+#include "random-source.h"
+#include "share-range.h"
+#include "thread-pool.h"
+
 #include <cstdint>
-#include <random>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
-using Share = std::pair<uint64_t, uint64_t>;
+// The secret recovered despite corrupted shares, and the x-values of the shares which were wrong
+struct RobustRecovery {
+	uint64_t secret;
+	std::vector<uint64_t> faultyXValues;
+};
 
 class ShamirsSecretSharing {
 public:
-	ShamirsSecretSharing(uint64_t secret, uint64_t threshold);	
+	ShamirsSecretSharing(uint64_t secret, uint64_t threshold, std::shared_ptr<RandomSource> randomSource = nullptr);
 
 	uint64_t getNumShares() const;
 	uint64_t getThreshold() const;
+	unsigned getNumThreads() const;
+	void setNumThreads(unsigned numThreads);
 	void generateAdditionalShares(uint64_t numToGenerate);
-	const std::vector<Share>& getShares() const;
+	const CompactShares& getShares() const;
+	std::vector<Share> getSharesAt(const std::vector<uint64_t> &xValues) const;
+	ShareRange getShareRange(uint64_t firstX, uint64_t count) const;
 
-	// Static because combining the shares is independent of state
+	// Static because combining the shares is independent of state. The 
+	// recovery threads are shared by every call.
+	static unsigned getRecoveryThreads();
+	static void setRecoveryThreads(unsigned numThreads);
 	static uint64_t recoverSecret(const std::vector<Share> &userShares);
+	static uint64_t recoverSecret(const CompactShares &userShares);
+	static uint64_t recoverSecret(uint64_t firstX, const uint64_t *yValues, size_t count);
+	static std::vector<Share> enrollShares(const std::vector<Share> &userShares, const std::vector<uint64_t> &newXValues);
+	static void refreshShares(std::vector<Share> &userShares, uint64_t threshold, 
+		std::shared_ptr<RandomSource> randomSource = nullptr);
+	static RobustRecovery recoverSecretRobust(const std::vector<Share> &userShares, uint64_t threshold);
 
 private:
 	uint64_t secret;
 	uint64_t threshold;
 
-	// 64-bit Mersenne Twister RNG
-	std::mt19937_64 rng;
+	// A ChaCha20 CSPRNG unless another source was given
+	std::shared_ptr<RandomSource> randomSource;
 
+	// secret, a_{1}, ..., a_{k-1}
 	std::vector<uint64_t> coefficients;
-	std::vector<Share> shares;
+
+	// The shares at x = 1, 2, ..., n, as y-values only
+	CompactShares shares;
+
+	// Continues from the last share generated, for x = shares.size()+1
+	DifferenceTable differenceTable;
+
+	// Shared so copies of the instance reuse the same workers
+	std::shared_ptr<ThreadPool> threadPool;
+
+	// Null when recovery runs on the calling thread
+	static std::shared_ptr<ThreadPool> recoveryThreadPool;
+	static std::mutex recoveryThreadMutex;
 
 	// The 8th Mersenne Prime, 2^61 - 1
 	// Mersenne Primes are used in cryptography because they lead to fast mod operations
-	static constexpr uint64_t p = (1ULL << 61) - 1;
+	static constexpr uint64_t p = Fp61::p;
 
 	std::vector<uint64_t> generateCoefficients();
 	uint64_t evaluatePolynomial(uint64_t x) const;
-	uint64_t getRandomIntegerInRange(uint64_t min, uint64_t max);
+	void evaluatePolynomial(const uint64_t *xValues, uint64_t *yValues, size_t count) const;
+	DifferenceTable makeDifferenceTable(uint64_t firstX) const;
+	void fillShares(uint64_t firstX, size_t count, uint64_t *yValues, DifferenceTable &table) const;
 	static uint64_t getMultiplicativeInverse(uint64_t a);
 	static uint64_t modPower(uint64_t base, uint64_t exp);
 	static uint64_t modSubtract(uint64_t a, uint64_t b);
@@ -0,0 +1,104 @@
+#ifndef SHAMIRS_SECRET_SHARING_SHARE_FILE_H
+#define SHAMIRS_SECRET_SHARING_SHARE_FILE_H
+
+#include "compact-shares.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/**
+ * A versioned binary file of shares, read through a memory map so recovery 
+ * runs over the mapped y-values in place. The file is a 64-byte header 
+ * followed by count little-endian y-words:
+ * 
+ *    offset  0   "SSSF"
+ *            4   version (2 bytes) | field id (2 bytes)
+ *            8   layout
+ *           16   threshold
+ *           24   first x-value
+ *           32   count
+ *           40   checksum of the y-words and the fields above
+ *           48   reserved, zero
+ * 
+ *  With the Range layout the file holds one secret's shares at x = firstX, 
+ *  ..., firstX+count-1. With the Column layout it holds one holder's shares, 
+ *  all at x = firstX, of count secrets split by a BatchDealer.
+ */
+class ShareFile {
+public:
+	enum class Layout : uint64_t { Range = 0, Column = 1 };
+
+	static constexpr uint16_t version = 1;
+	static constexpr uint16_t fieldFp61 = 1;
+	static constexpr size_t headerBytes = 64;
+
+	static void write(const std::string &path, Layout layout, uint64_t threshold, uint64_t firstX, 
+		const uint64_t *yValues, size_t count);
+	static void write(const std::string &path, const CompactShares &shares, uint64_t threshold);
+
+	explicit ShareFile(const std::string &path);
+	ShareFile(ShareFile &&other) noexcept;
+	ShareFile& operator=(ShareFile &&other) noexcept;
+	ShareFile(const ShareFile &) = delete;
+	ShareFile& operator=(const ShareFile &) = delete;
+	~ShareFile();
+
+	Layout getLayout() const;
+	uint64_t getThreshold() const;
+	uint64_t getFirstX() const;
+	size_t size() const;
+
+	// The y-values, in the mapped pages
+	const uint64_t* getYValues() const;
+
+	// Reads every page, so it is left to the caller
+	bool verifyChecksum() const;
+
+	static uint64_t checksum(Layout layout, uint64_t threshold, uint64_t firstX, const uint64_t *yValues, size_t count);
+
+private:
+	const unsigned char *map = nullptr;
+	size_t mapBytes = 0;
+
+	Layout layout = Layout::Range;
+	uint64_t threshold = 0;
+	uint64_t firstX = 0;
+	size_t count = 0;
+	uint64_t storedChecksum = 0;
+
+	friend class ShareFileWriter;
+	static uint64_t checksumWords(uint64_t hash, const uint64_t *words, size_t count);
+	static uint64_t checksumHeader(uint64_t hash, Layout layout, uint64_t threshold, uint64_t firstX, size_t count);
+	static void writeHeader(std::ostream &out, Layout layout, uint64_t threshold, uint64_t firstX, 
+		size_t count, uint64_t checksum);
+
+	void unmap();
+};
+
+
+/**
+ * Writes a share file a block of y-values at a time, for when the number of 
+ * shares isn't known up front. The header is filled in by close(), once the 
+ * count and checksum are known.
+ */
+class ShareFileWriter {
+public:
+	ShareFileWriter(const std::string &path, ShareFile::Layout layout, uint64_t threshold, uint64_t firstX);
+
+	size_t size() const;
+	void append(const uint64_t *yValues, size_t count);
+	void close();
+
+private:
+	std::ofstream out;
+	std::string path;
+	ShareFile::Layout layout;
+	uint64_t threshold;
+	uint64_t firstX;
+	size_t count = 0;
+	uint64_t hash = 0;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SHAMIRS_SECRET_SHARING_SHARE_RANGE_H
+#define SHAMIRS_SECRET_SHARING_SHARE_RANGE_H
+
+#include "compact-shares.h"
+#include "difference-table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+/**
+ * A lazy view of the shares at x = firstX, ..., firstX+count-1.
+ *  Nothing is stored except the polynomial, so any range costs O(k) memory. 
+ *  Random access evaluates the polynomial at one x-value, and iterating 
+ *  forward continues a difference table so each share costs k additions.
+ */
+class ShareRange {
+public:
+	uint64_t getFirstX() const;
+	size_t size() const;
+	bool empty() const;
+
+	Share operator[](size_t i) const;
+	Share at(size_t i) const;
+	ShareRange subrange(size_t offset, size_t count) const;
+
+	/**
+	 * A single pass over the range. Shares are computed when read and 
+	 * returned by value, so it's only an input iterator; the range's own 
+	 * operator[] is the random access.
+	 */
+	class const_iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = Share;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Share*;
+		using reference = Share;
+
+		// What it++ returns: the share read before stepping, without copying the table
+		class Proxy {
+		public:
+			explicit Proxy(Share share) : share(share) {}
+			Share operator*() const { return share; }
+
+		private:
+			Share share;
+		};
+
+		const_iterator(const ShareRange *range, size_t index) : range(range), index(index) {}
+		Share operator*() const;
+		const_iterator& operator++() { index++; return *this; }
+		Proxy operator++(int) { Proxy old(**this); index++; return old; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+	private:
+		const ShareRange *range;
+		size_t index;
+
+		// The last share read, and the table continuing after it
+		mutable DifferenceTable table;
+		mutable Share current = {0, 0};
+	};
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+private:
+	friend class ShamirsSecretSharing;
+	ShareRange(const std::vector<uint64_t> &coefficients, uint64_t firstX, size_t count);
+
+	// secret, a_{1}, ..., a_{k-1}
+	std::vector<uint64_t> coefficients;
+	uint64_t firstX;
+	size_t count;
+
+	uint64_t evaluate(uint64_t x) const;
+	DifferenceTable makeDifferenceTable(uint64_t x) const;
+};
+
+#endif
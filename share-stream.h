@@ -0,0 +1,31 @@
+#ifndef SHAMIRS_SECRET_SHARING_SHARE_STREAM_H
+#define SHAMIRS_SECRET_SHARING_SHARE_STREAM_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ * Splits and combines byte secrets of any length, such as files and keys.
+ *  The input is cut into 7-byte limbs (56 bits, so each fits in the field) and 
+ *  every limb is split with the same holder x-values. Each holder's stream is:
+ * 
+ *    "SSS1" | x (8 bytes) | threshold (8 bytes) | y_{1} ... y_{m} | y_{length}
+ * 
+ *  where every number is little-endian, y_{1} ... y_{m} are the shares of the 
+ *  limbs and y_{length} is the share of the secret's length in bytes. Both 
+ *  sides work a block of limbs at a time so memory use doesn't grow with the 
+ *  size of the secret.
+ */
+class ShareStream {
+public:
+	static void split(std::istream &secret, const std::vector<std::ostream*> &holders, uint64_t threshold);
+	static void combine(const std::vector<std::istream*> &holders, std::ostream &secret);
+
+	// The number of limbs processed per block
+	static constexpr size_t blockLimbs = 4096;
+	static constexpr size_t limbBytes = 7;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef SHAMIRS_SECRET_SHARING_STATS_H
+#define SHAMIRS_SECRET_SHARING_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counters and timers for seeing where the time goes, compiled in with
+ * -DSSS_STATS. Without it the SSS_STATS_ macros expand to nothing, so the
+ * hot paths are exactly as they were, and snapshot() returns zeros.
+ *  Each thread counts into its own slots, with relaxed atomics that only
+ *  that thread writes, so counting never takes a lock or shares a cache
+ *  line. snapshot() adds up every live thread and the threads that exited.
+ */
+class Stats {
+public:
+	enum class Counter {
+		Multiplications, 		// Field multiplications, including those done in SIMD lanes
+		Exponentiations, 		// Fp61::pow, which inversions go through
+		Inversions, 			// Fp61::inv
+		BatchInversions, 		// Fp61::batchInv calls, each costing one inversion
+		SharesGenerated,
+		Allocations, 			// operator new calls, from anywhere in the process
+		BytesAllocated,
+		Count
+	};
+
+	enum class Timer {
+		GenerateCoefficients,
+		EvaluatePolynomial,
+		GenerateAdditionalShares,
+		RecoverSecret,
+		Inversion,
+		Count
+	};
+
+	static constexpr size_t numCounters = static_cast<size_t>(Counter::Count);
+	static constexpr size_t numTimers = static_cast<size_t>(Timer::Count);
+
+	// The totals at one moment. Timers are inclusive, so nested ones overlap.
+	struct Snapshot {
+		std::array<uint64_t, numCounters> counters{};
+		std::array<uint64_t, numTimers> timerCalls{};
+		std::array<uint64_t, numTimers> timerNanoseconds{};
+
+		uint64_t get(Counter counter) const { return counters[static_cast<size_t>(counter)]; }
+		Snapshot operator-(const Snapshot &before) const;
+	};
+
+#ifdef SSS_STATS
+	static constexpr bool enabled = true;
+#else
+	static constexpr bool enabled = false;
+#endif
+
+	static Snapshot snapshot();
+	static void reset();
+	static void addAllocation(size_t bytes);
+	static const char* name(Counter counter);
+	static const char* name(Timer timer);
+
+
+	/**
+	 * Adds to one of the calling thread's counters.
+	 */
+	static inline void add(Counter counter, uint64_t amount)
+	{
+		std::atomic<uint64_t> &slot = local().counters[static_cast<size_t>(counter)];
+		slot.store(slot.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+
+	/**
+	 * Times its own scope into one of the calling thread's timers.
+	 */
+	class ScopedTimer {
+	public:
+		explicit ScopedTimer(Timer timer)
+		: timer(static_cast<size_t>(timer)), start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~ScopedTimer()
+		{
+			std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - this->start;
+			ThreadStats &stats = local();
+			stats.timerCalls[this->timer].store(stats.timerCalls[this->timer].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			stats.timerNanoseconds[this->timer].store(stats.timerNanoseconds[this->timer].load(std::memory_order_relaxed) + elapsed.count(), std::memory_order_relaxed);
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		size_t timer;
+		std::chrono::steady_clock::time_point start;
+	};
+
+private:
+	// One thread's slots, registered for snapshots while the thread lives
+	struct ThreadStats {
+		std::array<std::atomic<uint64_t>, numCounters> counters{};
+		std::array<std::atomic<uint64_t>, numTimers> timerCalls{};
+		std::array<std::atomic<uint64_t>, numTimers> timerNanoseconds{};
+
+		// The other live threads, linked without allocating so operator new can count
+		ThreadStats *previous = nullptr;
+		ThreadStats *next = nullptr;
+
+		ThreadStats();
+		~ThreadStats();
+	};
+
+	// The most recently started live thread, whose previous links to the rest
+	static ThreadStats *newestThread;
+
+	static inline ThreadStats& local()
+	{
+		thread_local ThreadStats stats;
+		return stats;
+	}
+};
+
+
+#ifdef SSS_STATS
+#define SSS_STATS_CONCAT_(a, b) a##b
+#define SSS_STATS_CONCAT(a, b) SSS_STATS_CONCAT_(a, b)
+#define SSS_STATS_COUNT(counter, amount) Stats::add(Stats::Counter::counter, (amount))
+#define SSS_STATS_TIMER(timer) Stats::ScopedTimer SSS_STATS_CONCAT(sssStatsTimer, __LINE__)(Stats::Timer::timer)
+#else
+#define SSS_STATS_COUNT(counter, amount) ((void)0)
+#define SSS_STATS_TIMER(timer) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SHAMIRS_SECRET_SHARING_THREAD_POOL_H
+#define SHAMIRS_SECRET_SHARING_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads for splitting a loop into contiguous ranges.
+ *  The calling thread works on the first range itself, so a pool of size 1 
+ *  has no workers and runs everything inline.
+ */
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned numThreads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned size() const;
+	void parallelFor(size_t count, const std::function<void(size_t, size_t)> &task);
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex callMutex;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	// The current job, read by the workers when the generation changes
+	const std::function<void(size_t, size_t)> *task = nullptr;
+	size_t count = 0;
+	unsigned long generation = 0;
+	unsigned remaining = 0;
+	bool stopping = false;
+	std::exception_ptr error;
+
+	void workerLoop(unsigned index);
+	void runRange(unsigned index, size_t count, const std::function<void(size_t, size_t)> &task);
+};
+
+#endif